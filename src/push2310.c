@@ -1,66 +1,532 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <time.h>
+#include <pthread.h>
+#include <math.h>
 #include "push2310.h"
+#ifdef KERNELS_X86
+#include <immintrin.h>
+#endif
 
 int main(int argc, char** argv) {
     // Initialise major variables and validate arguments
     ExitCodes exitStatus = EXIT_NORMAL;
-    Game* game = (Game*)malloc(sizeof(Game)); 
+    Game* game = (Game*)calloc(1, sizeof(Game));
+
+    /* Skip past any options, so that the player types and the save file are
+     * the only remaining arguments */
+    int optionCount = options_handler(argc, argv, game);
+    argc -= optionCount;
+    argv += optionCount;
     if (argc_player_types_handler(argc, argv, &exitStatus, game)) {
 	return exitStatus;
     }
 
-    // Validate and setup game file
-    FILE* gameFile = fopen(argv[3], "r");
-    char* rowsAndColumns = 0;
-    char* rowErrors = 0;
-    char* columnErrors = 0;
-    /* If EOF found in invalid location (e.g. player has typed a valid move
-     * yet triggered EOF), use this flag to handle this */
-    int eofFlag = 0;
-    if (file_setup(gameFile, game, &exitStatus, &rowsAndColumns,
-	    &rowErrors, &columnErrors, &eofFlag)) {
+    /* In batch mode, every save file is played (see play_batch), as it is
+     * for every pairing of player types in a tournament */
+    if (game->options.tournament) {
+	play_tournament(argc - 3, argv + 3, argv[1], argv[2], game);
+	free(game);
+	return exitStatus;
+    } else if (game->options.batch) {
+	play_batch(argc - 3, argv + 3, game);
+	free(game);
 	return exitStatus;
     }
 
-    /* Validate and set up game board. Represented as multi-dimensional
-     * dynamic array with each element as a char */ 
-    init_board(game, gameFile, &eofFlag);
-    if (file_contents_error_handler(game, rowErrors, columnErrors,
-	    &exitStatus)) {
-	free(rowsAndColumns);
-	fclose(gameFile);
-	game_free_memory(game);
+    // Validate and setup game file and game board
+    if (load_game(game, argv[3], &exitStatus)) {
 	return exitStatus;
     }
 
-    if (check_board_full(game)) {
-	free(rowsAndColumns);
+    /* Count the game tree (or time the kernels, or make a tablebase) rather
+     * than play the game */
+    if (game->options.perftDepth) {
+	run_perft(game);
+	game_free_memory(game);
+	return exitStatus;
+    } else if (game->options.benchPasses) {
+	run_bench(game);
+	game_free_memory(game);
+	return exitStatus;
+    } else if (game->options.tablebaseOut) {
+	exitStatus = make_tablebase(game);
 	game_free_memory(game);
-	fprintf(stderr, "Full board in load\n");
-	fclose(gameFile);
-	exitStatus = EXIT_FULL_BOARD;
 	return exitStatus;
     }
 
-    // Play the game, handle end of file on stdin when input required
-    play_game(game, &exitStatus, rowsAndColumns, gameFile, &eofFlag);
+    /* Play the game, handle end of file on stdin when input required. If EOF
+     * found in invalid location (e.g. player has typed a valid move yet
+     * triggered EOF), use this flag to handle this */
+    int eofFlag = 0;
+    start_journal(game);
+    play_game(game, &exitStatus, &eofFlag);
     if (exitStatus == EXIT_EOF) {
 	return exitStatus;
     }
 
     // Clean up after game is over, and calculate/display winner(s)
-    game_over(game, rowsAndColumns, gameFile); 
+    game_over(game);
     return exitStatus;
 }
 
+int load_game(Game* game, char* fileName, ExitCodes* exitStatus) {
+    // Use the fastest kernels, unless others were asked for
+    if (!game->options.kernels) {
+	game->options.kernels = find_kernels(0);
+    }
+
+    // Validate and setup game file
+    LoadedFile gameFile;
+    if (file_setup(fileName, &gameFile, game, exitStatus)) {
+	return *exitStatus;
+    }
+
+    /* Validate and set up game board, straight from the loaded file
+     * contents */
+    init_board(game, &gameFile);
+    if (file_contents_error_handler(game, exitStatus)) {
+	close_file(&gameFile);
+	game_free_memory(game);
+	return *exitStatus;
+    }
+
+    /* Build the packed game state from the validated board (replaying the
+     * moves of a journal on top of it), after which the file contents are no
+     * longer needed */
+    pack_board(game);
+    if (replay_journal(game, &gameFile, exitStatus)) {
+	close_file(&gameFile);
+	game_free_memory(game);
+	return *exitStatus;
+    }
+    if (gameFile.journal && game->options.journalName &&
+	    same_file(fileName, game->options.journalName)) {
+	game->journalResume = gameFile.position;
+    }
+    close_file(&gameFile);
+    if (check_board_full(game)) {
+	game_free_memory(game);
+	fprintf(stderr, "Full board in load\n");
+	*exitStatus = EXIT_FULL_BOARD;
+	return *exitStatus;
+    }
+    if (game->options.tablebaseName) {
+	open_tablebase(game);
+    }
+    return *exitStatus;
+}
+
+void play_batch(int argCount, char** args, Game* settings) {
+    size_t fileCount;
+    char** fileNames = list_save_files(argCount, args, &fileCount);
+    for (size_t i = 0; i < fileCount; i++) {
+	play_batch_game(fileNames[i], settings);
+    }
+    free_save_files(fileNames, fileCount);
+}
+
+char** list_save_files(int argCount, char** args, size_t* fileCount) {
+    char** names = 0;
+    size_t nameCapacity = 0;
+    *fileCount = 0;
+    int i = 0;
+    for (; i < argCount; i++) {
+	struct stat info;
+	DIR* directory = 0;
+	if (!stat(args[i], &info) && S_ISDIR(info.st_mode)) {
+	    directory = opendir(args[i]);
+	}
+
+	/* Anything other than a directory is played as a save file (and is
+	 * reported if it can't be) */
+	if (!directory) {
+	    if (!add_save_file(&names, fileCount, &nameCapacity,
+		    strdup(args[i]))) {
+		break;
+	    }
+	    continue;
+	}
+
+	/* Play every file in a directory, in order of name so that the
+	 * results are always in the same order */
+	size_t firstName = *fileCount;
+	struct dirent* entry;
+	int listed = 1;
+	while (listed && (entry = readdir(directory))) {
+	    size_t length = strlen(args[i]) + strlen(entry->d_name) + 2;
+	    char* name = (char*)malloc(length);
+	    if (!name) {
+		listed = 0;
+		break;
+	    }
+	    snprintf(name, length, "%s/%s", args[i], entry->d_name);
+	    if (entry->d_name[0] != '.' && !stat(name, &info) &&
+		    S_ISREG(info.st_mode)) {
+		listed = add_save_file(&names, fileCount, &nameCapacity,
+			name);
+	    } else {
+		free(name);
+	    }
+	}
+	closedir(directory);
+	if (!listed) {
+	    break;
+	}
+	qsort(names + firstName, *fileCount - firstName, sizeof(char*),
+		compare_names);
+    }
+
+    // Nothing is played if the list couldn't be made in full
+    if (i < argCount) {
+	fprintf(stderr, "Out of memory\n");
+	free_save_files(names, *fileCount);
+	*fileCount = 0;
+	return 0;
+    }
+    return names;
+}
+
+int add_save_file(char*** names, size_t* nameCount, size_t* nameCapacity,
+	char* name) {
+    if (!name) {
+	return 0;
+    }
+
+    // The list is only replaced once the bigger one has been allocated
+    if (*nameCount == *nameCapacity) {
+	size_t capacity = *nameCapacity ? 2 * *nameCapacity : 64;
+	char** grown = (char**)realloc(*names, capacity * sizeof(char*));
+	if (!grown) {
+	    free(name);
+	    return 0;
+	}
+	*names = grown;
+	*nameCapacity = capacity;
+    }
+    (*names)[(*nameCount)++] = name;
+    return 1;
+}
+
+void free_save_files(char** names, size_t nameCount) {
+    for (size_t i = 0; i < nameCount; i++) {
+	free(names[i]);
+    }
+    free(names);
+}
+
+int compare_names(const void* first, const void* second) {
+    return strcmp(*(char* const*)first, *(char* const*)second);
+}
+
+void play_batch_game(char* fileName, Game* settings) {
+    GameResult result;
+    play_headless_game(fileName, settings, settings->playerTypeO,
+	    settings->playerTypeX, &result);
+
+    // Games that can't be played are reported by their exit status
+    if (result.status != EXIT_NORMAL) {
+	printf("%s error %d\n", fileName, result.status);
+    } else {
+	printf("%s %c %d %d %ld %016" PRIx64 "\n", fileName, result.winner,
+		result.scoreO, result.scoreX, result.moveCount, result.key);
+	report_search(fileName, result.stats.searchIterations,
+		result.stats.searchSeconds);
+	report_timed(fileName, result.stats.timedMoves,
+		result.stats.timedDepths, result.stats.timedNodes,
+		result.stats.timedSeconds, result.stats.timedSlowest);
+	report_solve(fileName, result.stats.solveMoves,
+		result.stats.solveNodes, result.stats.solveSeconds,
+		result.stats.solveSlowest);
+    }
+}
+
+void play_headless_game(char* fileName, Game* settings, char playerTypeO,
+	char playerTypeX, GameResult* result) {
+    /* Every option carries over (a tournament's games each taking a single
+     * thread, as they are already played in parallel) */
+    result->status = EXIT_NORMAL;
+    Game* game = (Game*)calloc(1, sizeof(Game));
+    game->playerTypeO = playerTypeO;
+    game->playerTypeX = playerTypeX;
+    game->options = settings->options;
+    if (game->options.tournament) {
+	game->options.threads = 1;
+    }
+    game->verbosity = VERBOSITY_NONE;
+    if (load_game(game, fileName, &result->status)) {
+	return;
+    }
+
+    // Automated players never need stdin, so there is no EOF to handle
+    int eofFlag = 0;
+    play_game(game, &result->status, &eofFlag);
+    result->winner = (game->scoreO == game->scoreX) ? 'D' :
+	    (game->scoreO > game->scoreX) ? 'O' : 'X';
+    result->scoreO = game->scoreO;
+    result->scoreX = game->scoreX;
+    result->moveCount = game->moveCount;
+    result->key = game->key;
+    result->stats = game->stats;
+    game_free_memory(game);
+}
+
+void play_tournament(int argCount, char** args, char* typesO, char* typesX,
+	Game* settings) {
+    Tournament tournament;
+    tournament.fileNames = list_save_files(argCount, args,
+	    &tournament.fileCount);
+    tournament.typesO = typesO;
+    tournament.typesX = typesX;
+    tournament.settings = settings;
+    tournament.pairingCount = strlen(typesO) * strlen(typesX);
+    long int taskCount = tournament.fileCount * tournament.pairingCount;
+    tournament.workerCount = settings->options.threads ?
+	    settings->options.threads : sysconf(_SC_NPROCESSORS_ONLN);
+    if (tournament.workerCount < 1) {
+	tournament.workerCount = 1;
+    }
+
+    /* Each worker starts with an even share of the tasks (each task being a
+     * save file played with a pairing of player types), and is given a
+     * cache line of its own so that workers don't contend over their
+     * deques or tallies */
+    tournament.workers =
+	    (Worker**)calloc(tournament.workerCount, sizeof(Worker*));
+    int allocated = tournament.workers != 0;
+    for (int w = 0; allocated && w < tournament.workerCount; w++) {
+	Worker* worker;
+	if (posix_memalign((void**)&worker, CACHE_LINE_BYTES,
+		CACHE_LINE_ROUND(sizeof(Worker)))) {
+	    allocated = 0;
+	    break;
+	}
+	worker->tournament = &tournament;
+	worker->id = w;
+	pthread_mutex_init(&worker->lock, 0);
+	worker->top = taskCount * w / tournament.workerCount;
+	worker->bottom = taskCount * (w + 1) / tournament.workerCount;
+	worker->tallies =
+		(Tally*)calloc(tournament.pairingCount, sizeof(Tally));
+	tournament.workers[w] = worker;
+	allocated = worker->tallies != 0;
+    }
+    if (!allocated) {
+	fprintf(stderr, "Out of memory\n");
+	free_workers(&tournament);
+	free_save_files(tournament.fileNames, tournament.fileCount);
+	return;
+    }
+
+    /* The first worker is the main thread itself. Should a thread fail to
+     * start, no more are started, and the workers without a thread have
+     * their tasks stolen by those with one. */
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_t* threads =
+	    (pthread_t*)malloc(tournament.workerCount * sizeof(pthread_t));
+    int threadCount = 1;
+    while (threads && threadCount < tournament.workerCount &&
+	    !pthread_create(&threads[threadCount], 0, tournament_worker,
+	    tournament.workers[threadCount])) {
+	threadCount++;
+    }
+    tournament_worker(tournament.workers[0]);
+    for (int t = 1; t < threadCount; t++) {
+	pthread_join(threads[t], 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(threads);
+
+    // Add up and display the tallies of every pairing
+    printf("O X Games O-wins X-wins Draws Errors\n");
+    Stats stats;
+    memset(&stats, 0, sizeof(Stats));
+    for (int p = 0; p < tournament.pairingCount; p++) {
+	Tally total;
+	memset(&total, 0, sizeof(Tally));
+	for (int w = 0; w < tournament.workerCount; w++) {
+	    Tally* tally = &tournament.workers[w]->tallies[p];
+	    total.games += tally->games;
+	    total.winsO += tally->winsO;
+	    total.winsX += tally->winsX;
+	    total.draws += tally->draws;
+	    total.errors += tally->errors;
+	    add_stats(&total.stats, &tally->stats);
+	}
+	add_stats(&stats, &total.stats);
+	printf("%c %c %ld %ld %ld %ld %ld\n",
+		typesO[p / strlen(typesX)], typesX[p % strlen(typesX)],
+		total.games, total.winsO, total.winsX, total.draws,
+		total.errors);
+    }
+    double seconds = (end.tv_sec - start.tv_sec) +
+	    (end.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(stderr, "Played %ld games in %.3f s (%.0f games/s) with %d "
+	    "threads\n", taskCount, seconds,
+	    seconds > 0 ? taskCount / seconds : 0.0, threadCount);
+    if (strchr(typesO, '3') || strchr(typesX, '3')) {
+	report_search("Type 3 players (per thread)", stats.searchIterations,
+		stats.searchSeconds);
+    }
+    report_timed("Type 2 players", stats.timedMoves, stats.timedDepths,
+	    stats.timedNodes, stats.timedSeconds, stats.timedSlowest);
+    report_solve("Endgame", stats.solveMoves, stats.solveNodes,
+	    stats.solveSeconds, stats.solveSlowest);
+
+    free_workers(&tournament);
+    free_save_files(tournament.fileNames, tournament.fileCount);
+}
+
+void free_workers(Tournament* tournament) {
+    for (int w = 0; tournament->workers && w < tournament->workerCount;
+	    w++) {
+	Worker* worker = tournament->workers[w];
+	if (worker) {
+	    pthread_mutex_destroy(&worker->lock);
+	    free(worker->tallies);
+	    free(worker);
+	}
+    }
+    free(tournament->workers);
+}
+
+void* tournament_worker(void* argument) {
+    Worker* worker = (Worker*)argument;
+    Tournament* tournament = worker->tournament;
+    size_t typesX = strlen(tournament->typesX);
+    long int task;
+    while (next_task(worker, &task)) {
+	/* Tasks are numbered so that the pairings of a save file are next to
+	 * each other */
+	int pairing = task % tournament->pairingCount;
+	GameResult result;
+	play_headless_game(
+		tournament->fileNames[task / tournament->pairingCount],
+		tournament->settings, tournament->typesO[pairing / typesX],
+		tournament->typesX[pairing % typesX], &result);
+
+	Tally* tally = &worker->tallies[pairing];
+	if (result.status != EXIT_NORMAL) {
+	    tally->errors++;
+	    continue;
+	}
+	tally->games++;
+	add_stats(&tally->stats, &result.stats);
+	if (result.winner == 'O') {
+	    tally->winsO++;
+	} else if (result.winner == 'X') {
+	    tally->winsX++;
+	} else {
+	    tally->draws++;
+	}
+    }
+    return 0;
+}
+
+int next_task(Worker* worker, long int* task) {
+    // Take the newest task of the worker's own deque
+    int found = 0;
+    pthread_mutex_lock(&worker->lock);
+    if (worker->top < worker->bottom) {
+	*task = --worker->bottom;
+	found = 1;
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    /* Otherwise steal the oldest task of another worker. No tasks are ever
+     * added, so once every deque is empty there is nothing left to do. */
+    Tournament* tournament = worker->tournament;
+    for (int i = 1; !found && i < tournament->workerCount; i++) {
+	Worker* victim =
+		tournament->workers[(worker->id + i) % tournament->workerCount];
+	pthread_mutex_lock(&victim->lock);
+	if (victim->top < victim->bottom) {
+	    *task = victim->top++;
+	    found = 1;
+	}
+	pthread_mutex_unlock(&victim->lock);
+    }
+    return found;
+}
+
+int options_handler(int argc, char** argv, Game* game) {
+    int optionCount = 0;
+    for (int i = 1; i < argc && !strncmp(argv[i], "--", 2); i++) {
+	if (!strcmp(argv[i], "--verbosity=frames")) {
+	    game->verbosity = VERBOSITY_FRAMES;
+	} else if (!strcmp(argv[i], "--verbosity=moves")) {
+	    game->verbosity = VERBOSITY_MOVES;
+	} else if (!strcmp(argv[i], "--verbosity=result")) {
+	    game->verbosity = VERBOSITY_RESULT;
+	} else if (!strcmp(argv[i], "--verbosity=delta")) {
+	    game->verbosity = VERBOSITY_DELTA;
+	} else if (!strcmp(argv[i], "--batch")) {
+	    game->options.batch = 1;
+	} else if (!strcmp(argv[i], "--tournament")) {
+	    game->options.batch = game->options.tournament = 1;
+	} else if (!strncmp(argv[i], "--threads=", 10) &&
+		atoi(argv[i] + 10) > 0) {
+	    game->options.threads = atoi(argv[i] + 10);
+	} else if (!strncmp(argv[i], "--depth=", 8) &&
+		atoi(argv[i] + 8) > 0) {
+	    game->options.searchDepth = atoi(argv[i] + 8);
+	} else if (!strncmp(argv[i], "--iterations=", 13) &&
+		atol(argv[i] + 13) > 0) {
+	    game->options.iterations = atol(argv[i] + 13);
+	} else if (!strncmp(argv[i], "--move-time-ms=", 15) &&
+		atol(argv[i] + 15) > 0) {
+	    game->options.moveTimeMs = atol(argv[i] + 15);
+	} else if (!strcmp(argv[i], "--playout=zero")) {
+	    game->options.playout = PLAYOUT_ZERO;
+	} else if (!strcmp(argv[i], "--playout=one")) {
+	    game->options.playout = PLAYOUT_ONE;
+	} else if (!strncmp(argv[i], "--solve=", 8) &&
+		atol(argv[i] + 8) > 0) {
+	    game->options.solveCells = atol(argv[i] + 8);
+	} else if (!strncmp(argv[i], "--tablebase=", 12) && argv[i][12]) {
+	    game->options.tablebaseName = argv[i] + 12;
+	} else if (!strncmp(argv[i], "--make-tablebase=", 17) &&
+		argv[i][17]) {
+	    game->options.tablebaseOut = argv[i] + 17;
+	} else if (!strncmp(argv[i], "--perft=", 8) &&
+		atoi(argv[i] + 8) > 0) {
+	    game->options.perftDepth = atoi(argv[i] + 8);
+	} else if (!strncmp(argv[i], "--kernels=", 10) &&
+		find_kernels(argv[i] + 10)) {
+	    game->options.kernels = find_kernels(argv[i] + 10);
+	} else if (!strncmp(argv[i], "--bench=", 8) &&
+		atol(argv[i] + 8) > 0) {
+	    game->options.benchPasses = atol(argv[i] + 8);
+	} else if (!strncmp(argv[i], "--journal=", 10) && argv[i][10]) {
+	    game->options.journalName = argv[i] + 10;
+	} else {
+	    /* Leave unknown options in place, they are then reported as an
+	     * incorrect number of args */
+	    break;
+	}
+	optionCount++;
+    }
+    return optionCount;
+}
+
 int argc_player_types_handler(int argc, char** argv, ExitCodes* exitStatus,
 	Game* game) {
 
-    // Check correct number of args
-    if (argc != 4) {
+    /* Check correct number of args, batch mode takes any number of save
+     * files */
+    if (argc != 4 && !(game->options.batch && argc > 4)) {
 	free(game);
 	fprintf(stderr, "Usage: push2310 typeO typeX fname\n"); 
 	*exitStatus = EXIT_ARGS;
@@ -72,19 +538,14 @@ int argc_player_types_handler(int argc, char** argv, ExitCodes* exitStatus,
     game->playerTypeX = *argv[2];
 
     // flags for valid player types
-    char validPlayerTypes[3] = {'0', '1', 'H'};
-    int firstCheck = 0;
-    int secondCheck = 0;
-
-    /* Iterate through set of valid player types and check if the player types
-     * input by the user match */
-    for (int i = 0; i < 3; i++) {
-	if (game->playerTypeO == validPlayerTypes[i]) {
-	    firstCheck = 1;
-	}
-
-	if (game->playerTypeX == validPlayerTypes[i]) {
-	    secondCheck = 1;
+    int firstCheck = player_type_valid(game, game->playerTypeO);
+    int secondCheck = player_type_valid(game, game->playerTypeX);
+
+    /* In a tournament, every character of the player types is a player type
+     * (see play_tournament) */
+    for (int i = 1; game->options.tournament && i <= 2; i++) {
+	for (char* type = argv[i]; *type; type++) {
+	    firstCheck &= player_type_valid(game, *type);
 	}
     }
 
@@ -97,62 +558,271 @@ int argc_player_types_handler(int argc, char** argv, ExitCodes* exitStatus,
     return *exitStatus;
 }
 
-int file_setup(FILE* gameFile, Game* game, ExitCodes* exitStatus,
-	char** rowsAndColumns, char** rowErrors,
-	char** columnErrors, int* eofFlag) {
-    // Check if fopen failed (returns NULL on failure)
-    if (!gameFile) {
+int player_type_valid(Game* game, char type) {
+    // Set of valid player types
+    char validPlayerTypes[5] = {'0', '1', '2', '3', 'H'};
+
+    /* There is no one to make human moves in batch mode */
+    if (game->options.batch && type == 'H') {
+	return 0;
+    }
+
+    /* Iterate through set of valid player types and check if the player type
+     * input by the user matches */
+    for (int i = 0; i < 5; i++) {
+	if (type == validPlayerTypes[i]) {
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+int load_file(char* fileName, LoadedFile* file) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+	return 0;
+    }
+    file->contents = 0;
+    file->size = 0;
+    file->position = 0;
+    file->mapped = 0;
+    file->journal = 0;
+
+    /* Map regular files straight into memory, they are only ever read from
+     * start to end */
+    struct stat info;
+    if (!fstat(fd, &info) && S_ISREG(info.st_mode) && info.st_size > 0) {
+	void* contents = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (contents != MAP_FAILED) {
+	    posix_madvise(contents, info.st_size, POSIX_MADV_SEQUENTIAL);
+	    file->contents = contents;
+	    file->size = info.st_size;
+	    file->mapped = 1;
+	    close(fd);
+	    return 1;
+	}
+    }
+
+    /* Otherwise (e.g. a pipe), read the whole file in large blocks, doubling
+     * the buffer whenever it fills up. Running out of memory is the same as
+     * the file not being readable. */
+    size_t capacity = LOAD_BLOCK_SIZE;
+    file->contents = (char*)malloc(capacity);
+    ssize_t bytesRead;
+    while (file->contents && (bytesRead = read(fd, file->contents +
+	    file->size, capacity - file->size)) > 0) {
+	file->size += bytesRead;
+	if (file->size == capacity) {
+	    capacity *= 2;
+	    char* contents = (char*)realloc(file->contents, capacity);
+	    if (!contents) {
+		free(file->contents);
+	    }
+	    file->contents = contents;
+	}
+    }
+    close(fd);
+    return file->contents != 0;
+}
+
+void close_file(LoadedFile* file) {
+    if (file->mapped) {
+	munmap(file->contents, file->size);
+    } else {
+	free(file->contents);
+    }
+}
+
+const char* next_line(LoadedFile* file, size_t* length) {
+    if (file->position >= file->size) {
+	return 0;
+    }
+    const char* line = file->contents + file->position;
+    const char* newLine = memchr(line, '\n', file->size - file->position);
+
+    // The last line of the file need not end in a new line
+    *length = newLine ? (size_t)(newLine - line) :
+	    file->size - file->position;
+    file->position += *length + 1;
+    return line;
+}
+
+int parse_dimension(const char* start, const char* end, long int* value) {
+    /* Accept exactly what strtol would convert in full, i.e. leading
+     * whitespace, an optional sign, and then nothing but digits */
+    while (start < end && isspace((unsigned char)*start)) {
+	start++;
+    }
+    int negative = start < end && *start == '-';
+    if (start < end && (*start == '+' || *start == '-')) {
+	start++;
+    }
+    if (start == end) {
+	return 0;
+    }
+
+    // Large dimensions are clamped, these are too large to load anyway
+    *value = 0;
+    for (; start < end; start++) {
+	if (!isdigit((unsigned char)*start)) {
+	    return 0;
+	}
+	if (*value <= (LONG_MAX - 9) / 10) {
+	    *value = *value * 10 + (*start - '0');
+	} else {
+	    *value = LONG_MAX;
+	}
+    }
+    if (negative) {
+	*value = -*value;
+    }
+    return 1;
+}
+
+int file_setup(char* fileName, LoadedFile* gameFile, Game* game,
+	ExitCodes* exitStatus) {
+    // Check if the file could be opened
+    if (!load_file(fileName, gameFile)) {
 	free(game);
 	fprintf(stderr, "No file to load from\n");
 	*exitStatus = EXIT_FILE_READ;
 	return *exitStatus;
     }
-    // Get the rows and columns from the first line of the file, check spacing
-    *rowsAndColumns = read_line(gameFile, 81, eofFlag);
-    if (space_counter(rowsAndColumns) != 1) {
+    /* Journals and binary save files are recognised by their magic bytes,
+     * a journal starts with a binary save file of its initial position */
+    if (gameFile->size >= JOURNAL_HEADER_SIZE &&
+	    !memcmp(gameFile->contents, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE)) {
+	gameFile->journal = 1;
+	gameFile->position = JOURNAL_HEADER_SIZE;
+	if (gameFile->contents[JOURNAL_MAGIC_SIZE] != JOURNAL_VERSION) {
+	    game->rows = game->columns = 1; // Sentinel value
+	    return *exitStatus;
+	}
+    }
+    if (gameFile->size - gameFile->position >= BINARY_V1_HEADER_SIZE &&
+	    !memcmp(gameFile->contents + gameFile->position, BINARY_MAGIC,
+	    BINARY_MAGIC_SIZE)) {
+	binary_setup(gameFile, game);
+	return *exitStatus;
+    } else if (gameFile->journal) {
 	game->rows = game->columns = 1; // Sentinel value
 	return *exitStatus;
     }
 
-    /* Continue reading the file only if there is information still available
-     * to be be read */
-    if (!(*eofFlag) && strcmp(*rowsAndColumns, "test_EOF")) {
-	
-	/* Split rowsAndColumns via a space (via strtok), and then convert
-	 * them to long ints (via strtol) */	
-	game->rows = strtol(strtok(*rowsAndColumns, " "), rowErrors, 10);
-	
-	// Ensure there actually is a column dimension specified
-	char* columnsVerify = strtok(NULL, " ");
-	if (columnsVerify != NULL) {
-	    game->columns = strtol(columnsVerify, columnErrors, 10);
-	} else {
-	    game->columns = 1; // Sentinel value
-	}
-	/* Second line of file identifies first/current player read_line
-	 * returns malloc'd char*, dereference to get first char and free (did
-	 * not use fgetc to ensure the next file read avoids storing the new
-	 * line immediately after the current player character) */
-	char* currentPlayerRead = read_line(gameFile, 1, eofFlag);
-	
-	/* Verifies current player is only 1 letter (further verification in
-	 * file_contents_error_handler) */
-	if (strlen(currentPlayerRead) == 1) {
-	    game->currentPlayer = *currentPlayerRead;
-	} else {
-	    game->currentPlayer = 'f'; // Sentinel value
-	}
-	/* Ensure no invalid frees if EOF is found (as read_line free's the
-	 * char* it malloc'd to store the line to be read if EOF is found) */
-	if (!(*eofFlag) && strcmp(currentPlayerRead, "test_EOF")) {
-	    free(currentPlayerRead);
-	}
+    /* Get the rows and columns from the first line of the file, which must
+     * be two numbers separated by exactly one space */
+    size_t length;
+    const char* rowsAndColumns = next_line(gameFile, &length);
+    const char* space = rowsAndColumns ?
+	    memchr(rowsAndColumns, ' ', length) : 0;
+    const char* end = rowsAndColumns + length;
+    if (!space || memchr(space + 1, ' ', end - space - 1) ||
+	    !parse_dimension(rowsAndColumns, space, &game->rows) ||
+	    !parse_dimension(space + 1, end, &game->columns)) {
+	game->rows = game->columns = 1; // Sentinel value
+	return *exitStatus;
+    }
+
+    /* Second line of file identifies first/current player, verify it is only
+     * 1 letter (further verification in file_contents_error_handler) */
+    const char* currentPlayerRead = next_line(gameFile, &length);
+    if (currentPlayerRead && length == 1) {
+	game->currentPlayer = *currentPlayerRead;
+    } else {
+	game->currentPlayer = 'f'; // Sentinel value
     }
     return *exitStatus;
 }
 
-int file_contents_error_handler(Game* game, char* rowErrors,
-	char* columnErrors, ExitCodes* exitStatus) { 
+void binary_setup(LoadedFile* gameFile, Game* game) {
+    const unsigned char* header =
+	    (const unsigned char*)gameFile->contents + gameFile->position;
+    game->currentPlayer = header[BINARY_MAGIC_SIZE + 1];
+    game->rows = read_binary_u32(header + BINARY_MAGIC_SIZE + 4);
+    game->columns = read_binary_u32(header + BINARY_MAGIC_SIZE + 8);
+
+    /* The rest of the header, the score grid and the cell states must all
+     * be there in full (the sizes can't overflow, as each dimension is at
+     * most 32 bits) */
+    uint64_t cells = (uint64_t)game->rows * game->columns;
+    size_t headerSize = (header[BINARY_MAGIC_SIZE] == 1) ?
+	    BINARY_V1_HEADER_SIZE : BINARY_HEADER_SIZE;
+    if ((header[BINARY_MAGIC_SIZE] != BINARY_VERSION &&
+	    header[BINARY_MAGIC_SIZE] != 1) ||
+	    gameFile->size - gameFile->position < headerSize ||
+	    gameFile->size - gameFile->position - headerSize <
+	    BINARY_SCORES_SIZE(cells) + BINARY_STATES_SIZE(cells)) {
+	game->rows = game->columns = 1; // Sentinel value
+	return;
+    }
+    game->loadedScores = header + headerSize;
+    game->loadedStates = game->loadedScores + BINARY_SCORES_SIZE(cells);
+
+    // Anything after the board (i.e. the moves of a journal) comes next
+    gameFile->position += headerSize + BINARY_SCORES_SIZE(cells) +
+	    BINARY_STATES_SIZE(cells);
+}
+
+uint32_t read_binary_u32(const unsigned char* in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 |
+	    (uint32_t)in[3] << 24;
+}
+
+uint64_t read_binary_u64(const unsigned char* in) {
+    return read_binary_u32(in) | (uint64_t)read_binary_u32(in + 4) << 32;
+}
+
+char* write_binary_u32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+	*out++ = (char)(value >> (8 * i));
+    }
+    return out;
+}
+
+char* write_binary_u64(char* out, uint64_t value) {
+    out = write_binary_u32(out, (uint32_t)value);
+    return write_binary_u32(out, (uint32_t)(value >> 32));
+}
+
+int binary_contents_valid(Game* game) {
+    if (game->rows < 3 || game->columns < 3 || !game->arena ||
+	    (game->currentPlayer != 'X' && game->currentPlayer != 'O')) {
+	return 0;
+    }
+
+    /* Same rules as for a text save file: the border (other than the
+     * corners, which are always empty) has scores of 0, and the interior has
+     * scores of 1 to 9 */
+    for (long int r = 0; r < game->rows; r++) {
+	for (long int c = 0; c < game->columns; c++) {
+	    uint64_t i = (uint64_t)r * game->columns + c;
+	    int score = BINARY_SCORE_AT(i);
+	    int state = BINARY_STATE_AT(i);
+	    int border = r == 0 || r == game->rows - 1 || c == 0 ||
+		    c == game->columns - 1;
+	    int corner = (r == 0 || r == game->rows - 1) &&
+		    (c == 0 || c == game->columns - 1);
+	    if (state > CELL_X || (border && score != 0) ||
+		    (!border && (score < 1 || score > 9)) ||
+		    (corner && state != CELL_EMPTY)) {
+		return 0;
+	    }
+	    SCORE_AT(r, c) = score;
+	}
+    }
+    return 1;
+}
+
+int file_contents_error_handler(Game* game, ExitCodes* exitStatus) {
+    // Binary save files have their own (simpler) validation
+    if (game->loadedScores) {
+	if (!binary_contents_valid(game)) {
+	    fprintf(stderr, "Invalid file contents\n");
+	    *exitStatus = EXIT_FILE_CONTENTS;
+	}
+	return *exitStatus;
+    }
+
     // Initialise counters to check for invalid file contents
     int borderZeroCounter = 0;
     int interiorZeroCounter = 0;
@@ -160,8 +830,29 @@ int file_contents_error_handler(Game* game, char* rowErrors,
     int r, c;
 
     /* Iterate through each cell in game board, each cell has two chars, hence
-     * we must double the columns to iterate through each individual cell */
-    for (r = 0; r < game->rows; r++) {
+     * we must double the columns to iterate through each individual cell.
+     * There is no board to iterate through if the dimensions are invalid (or
+     * too large to allocate), these are reported below. Rows that are too
+     * short (or missing) are counted as invalid characters. */
+    for (r = 0; game->loadedRows && r < game->rows; r++) {
+	if (!game->loadedRows[r]) {
+	    invalidCharCounter++;
+	    continue;
+	}
+
+	/* Decode the score values as they are validated, so that nothing
+	 * needs to parse the score characters again. Corners (and any
+	 * invalid characters) are given a score of 0. */
+	game->options.kernels->decodeScores(game->loadedRows[r], game->columns,
+		&SCORE_AT(r, 0));
+
+	/* Rows that are entirely valid only need their border zeros counted,
+	 * only the others are checked a character at a time */
+	if (text_row_valid(game, r)) {
+	    borderZeroCounter += (r == 0 || r == game->rows - 1) ?
+		    game->columns - 2 : 2;
+	    continue;
+	}
 	for (c = 0; c < game->columns * 2; c++) {
 	    // Check interior for zeros and invalid chars
 	    validate_interior(r, c, game, &interiorZeroCounter,
@@ -176,7 +867,7 @@ int file_contents_error_handler(Game* game, char* rowErrors,
 	    if ((r == 0 || r == game->rows - 1) &&
 		    (c == 0 || c == 1 || c == LAST_CELL_COLUMN ||
 		    c == SCORE_COLUMN_OF_LAST_CELL)) {
-		if (game->board[r][c] != ' ') {
+		if (LOADED_AT(r, c) != ' ') {
 		    borderZeroCounter = -1;
 		}
 	    }
@@ -189,13 +880,12 @@ int file_contents_error_handler(Game* game, char* rowErrors,
      * zeros (1st/last cells in each row), hence:
      * borderZeroCounter == 2 * (game->columns - 2) + 2 * (game->rows - 2),
      * simplifying the above expression resuls in the expression below */
-    if (game->rows < 3 || game->columns < 3 || game->currentPlayer !=
-	    toupper(game->currentPlayer) ||
+    if (game->rows < 3 || game->columns < 3 || !game->loadedRows ||
+	    game->currentPlayer != toupper(game->currentPlayer) ||
 	    borderZeroCounter != 2 * (game->rows + game->columns) - 8 ||
 	    interiorZeroCounter != 0 || r != game->rows ||
-	    c != (game->columns) * 2 || invalidCharCounter != 0 ||
-	    (game->currentPlayer != 'X' && game->currentPlayer != 'O') ||
-	    *rowErrors != '\0' || *columnErrors != '\0') {
+	    invalidCharCounter != 0 ||
+	    (game->currentPlayer != 'X' && game->currentPlayer != 'O')) {
 	fprintf(stderr, "Invalid file contents\n");
 	*exitStatus = EXIT_FILE_CONTENTS;
     }
@@ -207,12 +897,12 @@ void validate_interior(int r, int c, Game* game, int* interiorZeroCounter,
     // Ensure indexing the interior values of the board
     if (r != 0 && r != game->rows - 1 && c != 0 && c !=
 	    SCORE_COLUMN_OF_LAST_CELL) {
-	if (game->board[r][c] == '0') {
+	if (LOADED_AT(r, c) == '0') {
 	    (*interiorZeroCounter)++;
-	} else if (!(c % 2 || isdigit(game->board[r][c])) ||
-		((c % 2) && game->board[r][c] != '.' &&
-		game->board[r][c] != 'O' &&
-		game->board[r][c] != 'X')) {
+	} else if (!(c % 2 || isdigit(LOADED_AT(r, c))) ||
+		((c % 2) && LOADED_AT(r, c) != '.' &&
+		LOADED_AT(r, c) != 'O' &&
+		LOADED_AT(r, c) != 'X')) {
 	    /* If even column, ensure cells are numbers (even as indexing from
 	     * 0, so first cell will be a score value). If odd column, ensure
 	     * cell is either empty (i.e. has a .) or occupied by a player's
@@ -227,12 +917,12 @@ void validate_border(int r, int c, Game* game, int* borderZeroCounter,
     
     // Count zeros in top and bottom row
     if (r == 0 || r == game->rows - 1) {
-	if (game->board[r][c] == '0') {
+	if (LOADED_AT(r, c) == '0') {
 	    (*borderZeroCounter)++;
-	} else if ((!(c % 2 || isdigit(game->board[r][c])) ||
-		((c % 2) && game->board[r][c] != '.' &&
-		game->board[r][c] != 'O' &&
-		game->board[r][c] != 'X')) && c > 1 &&
+	} else if ((!(c % 2 || isdigit(LOADED_AT(r, c))) ||
+		((c % 2) && LOADED_AT(r, c) != '.' &&
+		LOADED_AT(r, c) != 'O' &&
+		LOADED_AT(r, c) != 'X')) && c > 1 &&
 		c < SCORE_COLUMN_OF_LAST_CELL) {
 	    /* If even column, ensure cells are numbers (even as indexing from
 	     * 0, so first cell will be a score value). If odd column, ensure
@@ -243,12 +933,12 @@ void validate_border(int r, int c, Game* game, int* borderZeroCounter,
     } else if (c == 0 || c == SCORE_COLUMN_OF_LAST_CELL) {
 	/* Count zeros in first and last column that aren't in the top and
 	 * bottom row (else if ensures corners are avoided) */
-	if (game->board[r][c] == '0') {
+	if (LOADED_AT(r, c) == '0') {
 	    (*borderZeroCounter)++;
-	} else if (!(c % 2 || isdigit(game->board[r][c])) ||
-		((c % 2) && game->board[r][c] != '.' &&
-		game->board[r][c] != 'O' &&
-		game->board[r][c] != 'X')) {
+	} else if (!(c % 2 || isdigit(LOADED_AT(r, c))) ||
+		((c % 2) && LOADED_AT(r, c) != '.' &&
+		LOADED_AT(r, c) != 'O' &&
+		LOADED_AT(r, c) != 'X')) {
 	    /* If even column, ensure cells are numbers (even as indexing from
 	     * 0, so first cell will be a score value). If odd column, ensure
 	     * cell is either empty (i.e. has a .) or occupied by a player's
@@ -258,750 +948,2933 @@ void validate_border(int r, int c, Game* game, int* borderZeroCounter,
     }
 }
 
-int space_counter(char** input) {
-    int spaceCount = 0;
-    
-    // Iterate through string (end identified by finding the null terminator)
-    for (int i = 0; (*input)[i] != '\0'; i++) {
-	if((*input)[i] == ' ') {
-	    spaceCount++;
-	}
-    }
-    return spaceCount;
-}
-
-char* read_line(FILE* file, size_t size, int* eofFlag) {
-    char* result = (char*)malloc(sizeof(char) * size);
-    int position = 0;
-    int next = 0;
-
-    while(1) {
-	next = fgetc(file);
-	
-	/* Used to differentiate between when there is nothing but EOF to be
-	 * read and when there is information to be read (e.g. a human move)
-	 * and then EOF occurs */
-	if (next == EOF && position == 0) {
-	    free(result);
-	    return "test_EOF"; // Sentinel value
-	} else if (next == '\n' || next == EOF) {
-	    // Re-allocate if size too much/little
-	    if (position != size - 1) {
-		result = (char*)realloc((void*)result, position + 1);
-	    }
-	    if (next == EOF) {
-		*eofFlag = 1;
-	    }
-	    result[position] = '\0';
-	    return result;
-	} else {
-	    result[position++] = (char)next;
+int text_row_valid(Game* game, long int r) {
+    const char* row = game->loadedRows[r];
+    long int last = SCORE_COLUMN_OF_LAST_CELL;
+    int border = r == 0 || r == game->rows - 1;
+
+    // The first and last cells are checked here, the kernels check the rest
+    if (border && (row[0] != ' ' || row[1] != ' ' || row[last] != ' ' ||
+	    row[last + 1] != ' ')) {
+	return 0;
+    } else if (!border && (row[0] != '0' || row[last] != '0' ||
+	    !STONE_CHAR(row[1]) || !STONE_CHAR(row[last + 1]))) {
+	return 0;
+    }
+    return game->options.kernels->textValid(row + 2, last - 2,
+	    border ? '0' : '1', border ? '0' : '9');
+}
+
+const Kernels* find_kernels(const char* name) {
+    int count;
+    const Kernels* kernels = kernels_list(&count);
+    for (int i = 0; i < count; i++) {
+	if ((!name || !strcmp(name, kernels[i].name)) &&
+		kernels_supported(&kernels[i])) {
+	    return &kernels[i];
 	}
     }
+    return 0;
 }
 
-void init_board(Game* game, FILE* gameFile, int* eofFlag) {
-    game->board = (char**)malloc(game->rows * sizeof(char*));
+const Kernels* kernels_list(int* count) {
+    static const Kernels kernels[] = {
+#ifdef KERNELS_X86
+	{"avx2", text_valid_avx2, decode_scores_avx2, decode_stones_avx2,
+		sum_scores_avx2},
+	{"sse2", text_valid_sse2, decode_scores_sse2, decode_stones_sse2,
+		sum_scores_sse2},
+#endif
+	{"scalar", text_valid_scalar, decode_scores_scalar,
+		decode_stones_scalar, sum_scores_scalar}
+    };
+    *count = sizeof(kernels) / sizeof(Kernels);
+    return kernels;
+}
 
-    for (int r = 0; r < game->rows; r++) {
-	/* Each cell for the score character and the playing character
-	 * (i.e. an X, O, or a .), hence we must read in 2 * game->columns
-	 * worth of characters, as well as one more for the null character
-	 * as we are storing a string (NOTE: the null character is not present
-	 * in the save game format, only for the internal representation of
-	 * the game. */
-	game->board[r] =
-		read_line(gameFile, 2 * (game->columns) + 1, eofFlag);
-	
-	/* Handle incorrect number of rows specified in file by mallocing
-	 * meaningless space that will get freed regardless. This is to
-	 * prevent extra invalid frees that will cause memory problems. These
-	 * invalid dimensions are handled in file_contents_handler */
-	if (!strcmp(game->board[r], "test_EOF") && game->rows != r) {
-	    game->board[r] = 
-		    (char*)malloc(sizeof(char) * 2 * (game->columns) + 1);
-	}
-    }
-    /* Any EOF issues are handled elsewhere, this is simply present in the
-     * function as read_line requires it as a parameter */
-    *eofFlag = 0;
+int kernels_supported(const Kernels* kernels) {
+#ifdef KERNELS_X86
+    // CPUID is checked once, when the program starts
+    if (!strcmp(kernels->name, "avx2")) {
+	return __builtin_cpu_supports("avx2");
+    } else if (!strcmp(kernels->name, "sse2")) {
+	return __builtin_cpu_supports("sse2");
+    }
+#endif
+    return 1;
 }
 
-int check_board_full(Game* game) {
-    /* Iterate through the interior cells of the board, searching for an empty
-     * cell */
-    for (int r = 1; r < game->rows - 1; r++) {
-	for (int c = 3; c < SCORE_COLUMN_OF_LAST_CELL; c++) {
-	    if (game->board[r][c] == '.') {
-		return EXIT_NORMAL;
-	    }
+int text_valid_scalar(const char* text, long int length, char low,
+	char high) {
+    for (long int i = 0; i < length; i += 2) {
+	if (text[i] < low || text[i] > high || !STONE_CHAR(text[i + 1])) {
+	    return 0;
 	}
     }
-    return EXIT_FULL_BOARD;
+    return 1;
 }
 
-void play_game(Game* game, ExitCodes* exitStatus, char* rowsAndColumns,
-	FILE* gameFile, int* eofFlag) {
-    // Print the game board
-    for (int r = 0; r < game->rows; r++) {
-	printf("%s\n", game->board[r]);
+void decode_scores_scalar(const char* row, long int cells, uint8_t* scores) {
+    for (long int i = 0; i < cells; i++) {
+	char score = row[2 * i];
+	scores[i] = (score >= '0' && score <= '9') ? score - '0' : 0;
     }
-    
-    char* move = 0;
-    char* rowMoveErrors = 0;
-    char* columnMoveErrors = 0;
+}
 
-    // Play game until interior is full, at this point the game is over
-    do {
-	// Calculate the appropriate move
-	game_move(&move, &rowMoveErrors, &columnMoveErrors, game,
-		exitStatus, eofFlag);
-	/* Handle EOF on stdin when input required. The necessary stderr
-	 * message is handled already in game_move in the situation of a valid
-	 * human move followed by EOF. */
-	if (!strcmp(move, "test_EOF")) { 
-	    if (!(*eofFlag)) {
-		fprintf(stderr, "End of file\n");	
-	    }
-	    free(rowsAndColumns);
-	    game_free_memory(game);
-	    fclose(gameFile);
-	    return;
+void decode_stones_scalar(const char* row, long int cells, BoardWord* cellsO,
+	BoardWord* cellsX) {
+    for (long int i = 0; i < cells; i++) {
+	if (row[2 * i + 1] == 'O') {
+	    cellsO[i / WORD_BITS] |= CELL_BIT(i);
+	} else if (row[2 * i + 1] == 'X') {
+	    cellsX[i / WORD_BITS] |= CELL_BIT(i);
 	}
+    }
+}
 
-	/* To check for an automated move after processing game_move, the
-	 * move variable is set to the sentinel value of "automated". In the
-	 * rare event that the user types "automated" as their human move,
-	 * ensure to free this invalid move, as the sentinel value for
-	 * "automated" exists to ensure that invalid free's do not occur. */
-	if(!strcmp(rowMoveErrors, "automatedHuman")) {
-	    free(move);
-	    continue;
+int sum_scores_scalar(const uint8_t* scores, const BoardWord* cells,
+	long int words) {
+    /* Only visit the set bits of each word, by repeatedly taking (and then
+     * clearing) the lowest set bit */
+    int score = 0;
+    for (long int w = 0; w < words; w++) {
+	for (BoardWord bits = cells[w]; bits; bits &= bits - 1) {
+	    score += scores[w * WORD_BITS + __builtin_ctzll(bits)];
 	}
+    }
+    return score;
+}
 
-	// Execute the move decided by game_move
-	play_move(rowMoveErrors, columnMoveErrors, game);
-
-	/* Only free human moves as automated moves do not allocate memory to
-	 * process a move from stdin (i.e. from the user) */
-	if (strcmp(move, "automated")) {
-	    free(move);
+#ifdef KERNELS_X86
+/* The SSE2 kernels take 16 characters (or cells) at a time, and the AVX2
+ * kernels 32, leaving the rest of a row to the scalar kernels. Characters
+ * are compared as unsigned bytes, so a character is from low to high if it
+ * is no more than (high - low) above low. */
+__attribute__((target("sse2")))
+int text_valid_sse2(const char* text, long int length, char low, char high) {
+    const __m128i dot = _mm_set1_epi8('.');
+    const __m128i stoneO = _mm_set1_epi8('O');
+    const __m128i stoneX = _mm_set1_epi8('X');
+    const __m128i lowest = _mm_set1_epi8(low);
+    const __m128i range = _mm_set1_epi8(high - low);
+    long int i = 0;
+    for (; i + 16 <= length; i += 16) {
+	__m128i chars = _mm_loadu_si128((const __m128i*)(text + i));
+	__m128i stones = _mm_or_si128(_mm_cmpeq_epi8(chars, dot),
+		_mm_or_si128(_mm_cmpeq_epi8(chars, stoneO),
+		_mm_cmpeq_epi8(chars, stoneX)));
+	__m128i offset = _mm_sub_epi8(chars, lowest);
+	__m128i scores = _mm_cmpeq_epi8(_mm_min_epu8(offset, range), offset);
+	if (((_mm_movemask_epi8(stones) & 0xAAAA) |
+		(_mm_movemask_epi8(scores) & 0x5555)) != 0xFFFF) {
+	    return 0;
 	}
-    } while(!check_board_full(game));
+    }
+    return text_valid_scalar(text + i, length - i, low, high);
 }
 
-void game_move(char** move, char** rowMoveErrors, char** columnMoveErrors,
-	Game* game, ExitCodes* exitStatus, int* eofFlag) {
+__attribute__((target("sse2")))
+void decode_scores_sse2(const char* row, long int cells, uint8_t* scores) {
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i low = _mm_set1_epi16(0xFF);
+    long int i = 0;
+    for (; i + 16 <= cells; i += 16) {
+	// Keep the score (even) characters, packed into one vector
+	__m128i first = _mm_loadu_si128((const __m128i*)(row + 2 * i));
+	__m128i second = _mm_loadu_si128((const __m128i*)(row + 2 * i + 16));
+	__m128i values = _mm_sub_epi8(_mm_packus_epi16(
+		_mm_and_si128(first, low), _mm_and_si128(second, low)), zero);
+	values = _mm_and_si128(values,
+		_mm_cmpeq_epi8(_mm_min_epu8(values, nine), values));
+	_mm_storeu_si128((__m128i*)(scores + i), values);
+    }
+    decode_scores_scalar(row + 2 * i, cells - i, scores + i);
+}
 
-    /* Type 0 Moves - Ensure this only executes if the current player is a
-     * type 0 player. */
-    if ((game->currentPlayer == 'O' && game->playerTypeO == '0') ||
-	    (game->currentPlayer == 'X' && game->playerTypeX == '0')) {
-	type_zero_move(move, rowMoveErrors, columnMoveErrors, game);
-	return;
+__attribute__((target("sse2")))
+void decode_stones_sse2(const char* row, long int cells, BoardWord* cellsO,
+	BoardWord* cellsX) {
+    const __m128i stoneO = _mm_set1_epi8('O');
+    const __m128i stoneX = _mm_set1_epi8('X');
+    long int i = 0;
+    for (; i + WORD_BITS <= cells; i += WORD_BITS) {
+	for (int part = 0; part < WORD_BITS; part += 16) {
+	    // Keep the stone (odd) characters, packed into one vector
+	    const char* chars = row + 2 * (i + part);
+	    __m128i first = _mm_loadu_si128((const __m128i*)chars);
+	    __m128i second = _mm_loadu_si128((const __m128i*)(chars + 16));
+	    __m128i stones = _mm_packus_epi16(_mm_srli_epi16(first, 8),
+		    _mm_srli_epi16(second, 8));
+	    cellsO[i / WORD_BITS] |= (BoardWord)_mm_movemask_epi8(
+		    _mm_cmpeq_epi8(stones, stoneO)) << part;
+	    cellsX[i / WORD_BITS] |= (BoardWord)_mm_movemask_epi8(
+		    _mm_cmpeq_epi8(stones, stoneX)) << part;
+	}
     }
-     
-    /* Type 1 Moves - Ensure this only executes if the current player is a
-     * type 1 player. */
-    char opponent = (game->currentPlayer == 'X') ? 'O' : 'X';
-    if ((game->currentPlayer == 'O' && game->playerTypeO == '1') ||
+    decode_stones_scalar(row + 2 * i, cells - i, cellsO + i / WORD_BITS,
+	    cellsX + i / WORD_BITS);
+}
+
+__attribute__((target("sse2")))
+int sum_scores_sse2(const uint8_t* scores, const BoardWord* cells,
+	long int words) {
+    // Each byte selects its own bit of the byte of the cells it is spread from
+    const __m128i select = _mm_set_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128,
+	    64, 32, 16, 8, 4, 2, 1);
+    __m128i total = _mm_setzero_si128();
+    for (long int w = 0; w < words; w++) {
+	for (int part = 0; part < WORD_BITS && cells[w] >> part; part += 16) {
+	    /* Spread the 16 bits of this part of the word over 16 bytes,
+	     * each byte being all ones if its cell is set */
+	    __m128i bits = _mm_cvtsi32_si128((cells[w] >> part) & 0xFFFF);
+	    bits = _mm_unpacklo_epi8(bits, bits);
+	    bits = _mm_unpacklo_epi16(bits, bits);
+	    bits = _mm_unpacklo_epi32(bits, bits);
+	    bits = _mm_cmpeq_epi8(_mm_and_si128(bits, select), select);
+	    __m128i values = _mm_and_si128(bits, _mm_loadu_si128(
+		    (const __m128i*)(scores + w * WORD_BITS + part)));
+	    total = _mm_add_epi64(total,
+		    _mm_sad_epu8(values, _mm_setzero_si128()));
+	}
+    }
+    return _mm_cvtsi128_si32(total) +
+	    _mm_cvtsi128_si32(_mm_unpackhi_epi64(total, total));
+}
+
+__attribute__((target("avx2")))
+int text_valid_avx2(const char* text, long int length, char low, char high) {
+    const __m256i dot = _mm256_set1_epi8('.');
+    const __m256i stoneO = _mm256_set1_epi8('O');
+    const __m256i stoneX = _mm256_set1_epi8('X');
+    const __m256i lowest = _mm256_set1_epi8(low);
+    const __m256i range = _mm256_set1_epi8(high - low);
+    long int i = 0;
+    for (; i + 32 <= length; i += 32) {
+	__m256i chars = _mm256_loadu_si256((const __m256i*)(text + i));
+	__m256i stones = _mm256_or_si256(_mm256_cmpeq_epi8(chars, dot),
+		_mm256_or_si256(_mm256_cmpeq_epi8(chars, stoneO),
+		_mm256_cmpeq_epi8(chars, stoneX)));
+	__m256i offset = _mm256_sub_epi8(chars, lowest);
+	__m256i scores = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, range),
+		offset);
+	if ((((uint32_t)_mm256_movemask_epi8(stones) & 0xAAAAAAAA) |
+		((uint32_t)_mm256_movemask_epi8(scores) & 0x55555555)) !=
+		0xFFFFFFFF) {
+	    return 0;
+	}
+    }
+    return text_valid_sse2(text + i, length - i, low, high);
+}
+
+__attribute__((target("avx2")))
+void decode_scores_avx2(const char* row, long int cells, uint8_t* scores) {
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i low = _mm256_set1_epi16(0xFF);
+    long int i = 0;
+    for (; i + 32 <= cells; i += 32) {
+	/* Keep the score (even) characters, packed into one vector (packing
+	 * works within each half, so the quarters are then put in order) */
+	__m256i first = _mm256_loadu_si256((const __m256i*)(row + 2 * i));
+	__m256i second = _mm256_loadu_si256(
+		(const __m256i*)(row + 2 * i + 32));
+	__m256i values = _mm256_permute4x64_epi64(_mm256_packus_epi16(
+		_mm256_and_si256(first, low), _mm256_and_si256(second, low)),
+		0xD8);
+	values = _mm256_sub_epi8(values, zero);
+	values = _mm256_and_si256(values,
+		_mm256_cmpeq_epi8(_mm256_min_epu8(values, nine), values));
+	_mm256_storeu_si256((__m256i*)(scores + i), values);
+    }
+    decode_scores_sse2(row + 2 * i, cells - i, scores + i);
+}
+
+__attribute__((target("avx2")))
+void decode_stones_avx2(const char* row, long int cells, BoardWord* cellsO,
+	BoardWord* cellsX) {
+    const __m256i stoneO = _mm256_set1_epi8('O');
+    const __m256i stoneX = _mm256_set1_epi8('X');
+    long int i = 0;
+    for (; i + WORD_BITS <= cells; i += WORD_BITS) {
+	for (int part = 0; part < WORD_BITS; part += 32) {
+	    // Keep the stone (odd) characters, packed into one vector
+	    const char* chars = row + 2 * (i + part);
+	    __m256i first = _mm256_loadu_si256((const __m256i*)chars);
+	    __m256i second = _mm256_loadu_si256(
+		    (const __m256i*)(chars + 32));
+	    __m256i stones = _mm256_permute4x64_epi64(_mm256_packus_epi16(
+		    _mm256_srli_epi16(first, 8), _mm256_srli_epi16(second, 8)),
+		    0xD8);
+	    cellsO[i / WORD_BITS] |= (BoardWord)(uint32_t)_mm256_movemask_epi8(
+		    _mm256_cmpeq_epi8(stones, stoneO)) << part;
+	    cellsX[i / WORD_BITS] |= (BoardWord)(uint32_t)_mm256_movemask_epi8(
+		    _mm256_cmpeq_epi8(stones, stoneX)) << part;
+	}
+    }
+    decode_stones_scalar(row + 2 * i, cells - i, cellsO + i / WORD_BITS,
+	    cellsX + i / WORD_BITS);
+}
+
+__attribute__((target("avx2")))
+int sum_scores_avx2(const uint8_t* scores, const BoardWord* cells,
+	long int words) {
+    /* Each byte is spread from the byte of the cells of its eighth of the 32
+     * bits, and selects its own bit of that byte */
+    const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1,
+	    1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i select = _mm256_set1_epi64x(0x8040201008040201LL);
+    __m256i total = _mm256_setzero_si256();
+    for (long int w = 0; w < words; w++) {
+	for (int part = 0; part < WORD_BITS && cells[w] >> part; part += 32) {
+	    __m256i bits = _mm256_shuffle_epi8(_mm256_set1_epi32(
+		    (int32_t)(uint32_t)(cells[w] >> part)), spread);
+	    bits = _mm256_cmpeq_epi8(_mm256_and_si256(bits, select), select);
+	    __m256i values = _mm256_and_si256(bits, _mm256_loadu_si256(
+		    (const __m256i*)(scores + w * WORD_BITS + part)));
+	    total = _mm256_add_epi64(total,
+		    _mm256_sad_epu8(values, _mm256_setzero_si256()));
+	}
+    }
+    __m128i half = _mm_add_epi64(_mm256_castsi256_si128(total),
+	    _mm256_extracti128_si256(total, 1));
+    return _mm_cvtsi128_si32(half) +
+	    _mm_cvtsi128_si32(_mm_unpackhi_epi64(half, half));
+}
+#endif
+
+char* read_input_line(InputBuffer* input, int* eofFlag) {
+    if (!input->data) {
+	input->capacity = INPUT_BLOCK_SIZE;
+	input->data = (char*)malloc(input->capacity);
+	input->interactive = isatty(STDIN_FILENO) && isatty(STDOUT_FILENO);
+    }
+
+    while (1) {
+	char* line = input->data + input->start;
+	char* newLine = memchr(line, '\n', input->end - input->start);
+	if (newLine) {
+	    *newLine = '\0';
+	    input->start = newLine - input->data + 1;
+	    return line;
+	} else if (input->eof) {
+	    /* Used to differentiate between when there is nothing but EOF to
+	     * be read and when there is information to be read (e.g. a human
+	     * move) and then EOF occurs */
+	    if (input->start == input->end) {
+		return 0;
+	    }
+	    *eofFlag = 1;
+	    input->data[input->end] = '\0';
+	    input->start = input->end;
+	    return line;
+	}
+
+	/* No whole line is buffered, so move what there is of the line to the
+	 * front of the buffer (growing the buffer if the line fills it, while
+	 * leaving room for the null) and read in the next block */
+	memmove(input->data, line, input->end - input->start);
+	input->end -= input->start;
+	input->start = 0;
+	if (input->end + 1 >= input->capacity) {
+	    input->capacity *= 2;
+	    input->data = (char*)realloc(input->data, input->capacity);
+	}
+
+	/* As stdio would, display any prompt before waiting on a user at a
+	 * terminal */
+	if (input->interactive) {
+	    fflush(stdout);
+	}
+	ssize_t bytesRead = read(STDIN_FILENO, input->data + input->end,
+		input->capacity - input->end - 1);
+	if (bytesRead > 0) {
+	    input->end += bytesRead;
+	} else {
+	    input->eof = 1;
+	}
+    }
+}
+
+int parse_move(const char* move, long int* row, long int* column) {
+    /* Two numbers separated by exactly one space, as strtol would convert
+     * them in full, and so that the move neither starts with a space or a
+     * tab nor ends in anything but a digit */
+    if (*move == ' ' || *move == '\t' || !parse_number(&move, row) ||
+	    *move++ != ' ' || !parse_number(&move, column)) {
+	return 0;
+    }
+    return *move == '\0';
+}
+
+int parse_number(const char** cursor, long int* value) {
+    // Leading whitespace (other than the space between numbers) and a sign
+    const char* in = *cursor;
+    while (*in != ' ' && isspace((unsigned char)*in)) {
+	in++;
+    }
+    int negative = *in == '-';
+    if (*in == '+' || *in == '-') {
+	in++;
+    }
+    if (!isdigit((unsigned char)*in)) {
+	return 0;
+    }
+
+    // Large numbers are clamped, these are out of range anyway
+    *value = 0;
+    for (; isdigit((unsigned char)*in); in++) {
+	if (*value <= (LONG_MAX - 9) / 10) {
+	    *value = *value * 10 + (*in - '0');
+	} else {
+	    *value = LONG_MAX;
+	}
+    }
+    if (negative) {
+	*value = -*value;
+    }
+    *cursor = in;
+    return 1;
+}
+
+long int line_words(long int cells) {
+    /* Lines no wider than half a cache line are rounded up to a power of two
+     * so that they never straddle a cache line, wider lines are rounded up to
+     * a whole number of cache lines so that every line starts on a cache
+     * line. */
+    long int words = (cells - 1) / WORD_BITS + 1;
+    long int lineWords = 1;
+    while (lineWords < words && lineWords < CACHE_LINE_WORDS) {
+	lineWords *= 2;
+    }
+    if (words > CACHE_LINE_WORDS) {
+	lineWords = (words + CACHE_LINE_WORDS - 1) / CACHE_LINE_WORDS *
+		CACHE_LINE_WORDS;
+    }
+    return lineWords;
+}
+
+size_t arena_part(size_t* size, size_t partSize) {
+    size_t offset = *size;
+    *size += CACHE_LINE_ROUND(partSize);
+    return offset;
+}
+
+int alloc_arena(Game* game) {
+    // Words per bitboard row (and per bitboard column)
+    game->rowWords = line_words(game->columns);
+    game->columnWords = line_words(game->rows);
+
+    // Check the board isn't so large that the sizes below overflow
+    if ((size_t)game->rows > SIZE_MAX / 16 / SCORE_STRIDE ||
+	    (size_t)game->columns > SIZE_MAX / 16 / game->rows) {
+	return 0;
+    }
+    size_t bitboardSize = game->rows * game->rowWords * sizeof(BoardWord);
+    size_t columnBitboardSize =
+	    game->columns * game->columnWords * sizeof(BoardWord);
+
+    // Offsets of each part of the arena, each part starts on a cache line
+    size_t size = 0;
+    size_t offsetO = arena_part(&size, bitboardSize);
+    size_t offsetX = arena_part(&size, bitboardSize);
+    size_t offsetColumnO = arena_part(&size, columnBitboardSize);
+    size_t offsetColumnX = arena_part(&size, columnBitboardSize);
+    size_t offsetRowStones = arena_part(&size,
+	    game->rows * sizeof(long int));
+    size_t offsetColumnStones = arena_part(&size,
+	    game->columns * sizeof(long int));
+    size_t offsetMask = arena_part(&size,
+	    game->rowWords * sizeof(BoardWord));
+    size_t offsetEmptyRows = arena_part(&size,
+	    ((game->rows - 1) / WORD_BITS + 1) * sizeof(BoardWord));
+    size_t offsetRowEmpties = arena_part(&size,
+	    game->rows * sizeof(long int));
+    size_t offsetScores = arena_part(&size, game->rows * SCORE_STRIDE);
+    size_t offsetZobrist = arena_part(&size,
+	    2 * game->rows * game->columns * sizeof(uint64_t));
+    size_t offsetMoves = arena_part(&size, MOVE_CAPACITY * sizeof(Move));
+    size_t offsetColumnSums = arena_part(&size,
+	    game->columns * sizeof(ColumnSums));
+    size_t offsetPushColumns = arena_part(&size,
+	    game->rowWords * sizeof(BoardWord));
+    size_t offsetFrame = arena_part(&size, FRAME_SIZE);
+    size_t offsetLoaded = arena_part(&size, game->rows * sizeof(char*));
+    game->arenaSize = size;
+
+    /* Allocate the whole arena at once, with enough slack to start it on a
+     * cache line */
+    game->arena = (char*)malloc(size + CACHE_LINE_BYTES - 1);
+    if (!game->arena) {
+	return 0;
+    }
+    char* base = game->arena + (CACHE_LINE_BYTES -
+	    (uintptr_t)game->arena % CACHE_LINE_BYTES) % CACHE_LINE_BYTES;
+    memset(base, 0, size);
+
+    game->stonesO = (BoardWord*)(base + offsetO);
+    game->stonesX = (BoardWord*)(base + offsetX);
+    game->stonesByColumnO = (BoardWord*)(base + offsetColumnO);
+    game->stonesByColumnX = (BoardWord*)(base + offsetColumnX);
+    game->rowStones = (long int*)(base + offsetRowStones);
+    game->columnStones = (long int*)(base + offsetColumnStones);
+    game->interiorMask = (BoardWord*)(base + offsetMask);
+    game->emptyRows = (BoardWord*)(base + offsetEmptyRows);
+    game->rowEmpties = (long int*)(base + offsetRowEmpties);
+    game->scores = (uint8_t*)(base + offsetScores);
+    game->zobrist = (uint64_t*)(base + offsetZobrist);
+    game->moves = (Move*)(base + offsetMoves);
+    game->columnSums = (ColumnSums*)(base + offsetColumnSums);
+    game->pushColumns = (BoardWord*)(base + offsetPushColumns);
+    game->stateSize = offsetScores;
+    game->frame = base + offsetFrame;
+    game->loadedRows = (const char**)(base + offsetLoaded);
+    return 1;
+}
+
+void init_board(Game* game, LoadedFile* gameFile) {
+    // Invalid dimensions are handled in file_contents_error_handler
+    if (game->rows < 3 || game->columns < 3 || !alloc_arena(game) ||
+	    game->loadedScores) {
+	return;
+    }
+
+    for (long int r = 0; r < game->rows; r++) {
+	/* Each cell for the score character and the playing character
+	 * (i.e. an X, O, or a .), hence each row must have at least
+	 * 2 * game->columns characters (any extra characters are ignored).
+	 * Rows that are cut short (including rows missing due to EOF) are
+	 * left as NULL, and so are handled as invalid file contents in
+	 * file_contents_error_handler. */
+	size_t length;
+	const char* row = next_line(gameFile, &length);
+	if (row && length >= (size_t)(2 * game->columns)) {
+	    game->loadedRows[r] = row;
+	}
+    }
+}
+
+void pack_board(Game* game) {
+    for (long int c = 1; c < game->columns - 1; c++) {
+	game->interiorMask[c / WORD_BITS] |= CELL_BIT(c);
+    }
+
+    /* Start with every interior cell empty, set_cell then removes each
+     * occupied cell from the index as the stones are placed below */
+    game->emptyCells = (game->rows - 2) * (game->columns - 2);
+    for (long int r = 1; r < game->rows - 1; r++) {
+	game->rowEmpties[r] = game->columns - 2;
+	game->emptyRows[r / WORD_BITS] |= CELL_BIT(r);
+    }
+
+    /* Generate the key of each player's stone on each cell, from the cell
+     * alone (so that a cell has the same keys whatever the board), and start
+     * with the key of the empty board. set_cell then XORs in the key of each
+     * stone placed below. */
+    for (long int r = 0; r < game->rows; r++) {
+	for (long int c = 0; c < game->columns; c++) {
+	    uint64_t cell = (uint64_t)r << 33 | (uint64_t)c << 1;
+	    ZOBRIST_AT(r, c, 'O') = zobrist_mix(cell);
+	    ZOBRIST_AT(r, c, 'X') = zobrist_mix(cell | 1);
+	}
+    }
+    game->key = board_key(game) ^
+	    (game->currentPlayer == 'X' ? ZOBRIST_PLAYER_X : 0);
+
+    /* Each loaded cell is a score character (already decoded by
+     * file_contents_error_handler) followed by either a stone or a dot. The
+     * stones of a text row are decoded a block at a time (see Kernels)
+     * straight into the row's words, and each is then placed by set_cell. */
+    for (long int r = 0; r < game->rows; r++) {
+	BoardWord* rowO = ROW_WORDS_OF(game->stonesO, r);
+	BoardWord* rowX = ROW_WORDS_OF(game->stonesX, r);
+	if (!game->loadedStates) {
+	    game->options.kernels->decodeStones(game->loadedRows[r],
+		    game->columns, rowO, rowX);
+	    for (long int w = 0; w < game->rowWords; w++) {
+		BoardWord stonesO = rowO[w];
+		BoardWord stonesX = rowX[w];
+		rowO[w] = rowX[w] = 0;
+		for (; stonesO; stonesO &= stonesO - 1) {
+		    set_cell(game, r, w * WORD_BITS + __builtin_ctzll(stonesO),
+			    'O');
+		}
+		for (; stonesX; stonesX &= stonesX - 1) {
+		    set_cell(game, r, w * WORD_BITS + __builtin_ctzll(stonesX),
+			    'X');
+		}
+	    }
+	    continue;
+	}
+	for (long int c = 0; c < game->columns; c++) {
+	    char stone = loaded_stone(game, r, c);
+	    if (stone != '.') {
+		set_cell(game, r, c, stone);
+	    }
+	}
+    }
+}
+
+uint64_t zobrist_mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+uint64_t board_key(Game* game) {
+    uint64_t key = zobrist_mix((uint64_t)game->rows << 32 | game->columns);
+    for (long int r = 0; r < game->rows; r++) {
+	for (long int c = 0; c < game->columns; c++) {
+	    key = zobrist_mix(key ^ SCORE_AT(r, c));
+	}
+    }
+    return key;
+}
+
+uint64_t zobrist_hash(Game* game) {
+    uint64_t key = board_key(game) ^
+	    (game->currentPlayer == 'X' ? ZOBRIST_PLAYER_X : 0);
+    for (long int r = 0; r < game->rows; r++) {
+	for (long int c = 0; c < game->columns; c++) {
+	    char stone = cell_at(game, r, c);
+	    if (stone != '.') {
+		key ^= ZOBRIST_AT(r, c, stone);
+	    }
+	}
+    }
+    return key;
+}
+
+char loaded_stone(Game* game, long int r, long int c) {
+    if (!game->loadedStates) {
+	return LOADED_AT(r, 2 * c + 1);
+    }
+    switch (BINARY_STATE_AT((uint64_t)r * game->columns + c)) {
+	case CELL_O:
+	    return 'O';
+	case CELL_X:
+	    return 'X';
+	default:
+	    return '.';
+    }
+}
+
+char cell_at(Game* game, long int r, long int c) {
+    BoardWord bit = CELL_BIT(c);
+    if (ROW_WORDS_OF(game->stonesO, r)[c / WORD_BITS] & bit) {
+	return 'O';
+    } else if (ROW_WORDS_OF(game->stonesX, r)[c / WORD_BITS] & bit) {
+	return 'X';
+    }
+    return '.';
+}
+
+void set_cell(Game* game, long int r, long int c, char stone) {
+    BoardWord bit = CELL_BIT(c);
+    BoardWord* wordO = &ROW_WORDS_OF(game->stonesO, r)[c / WORD_BITS];
+    BoardWord* wordX = &ROW_WORDS_OF(game->stonesX, r)[c / WORD_BITS];
+    BoardWord columnBit = CELL_BIT(r);
+    BoardWord* columnWordO =
+	    &COLUMN_WORDS_OF(game->stonesByColumnO, c)[r / WORD_BITS];
+    BoardWord* columnWordX =
+	    &COLUMN_WORDS_OF(game->stonesByColumnX, c)[r / WORD_BITS];
+
+    /* Keep the running scores (and the key) up to date, only cells that
+     * actually change owner contribute to the change in score */
+    if (*wordO & bit) {
+	game->scoreO -= SCORE_AT(r, c);
+	game->key ^= ZOBRIST_AT(r, c, 'O');
+    } else if (*wordX & bit) {
+	game->scoreX -= SCORE_AT(r, c);
+	game->key ^= ZOBRIST_AT(r, c, 'X');
+    }
+    if (stone == 'O') {
+	game->scoreO += SCORE_AT(r, c);
+	game->key ^= ZOBRIST_AT(r, c, 'O');
+    } else if (stone == 'X') {
+	game->scoreX += SCORE_AT(r, c);
+	game->key ^= ZOBRIST_AT(r, c, 'X');
+    }
+
+    /* Keep the line counters, and the empty cell index, up to date if the
+     * cell has been filled or emptied */
+    int wasEmpty = !((*wordO | *wordX) & bit);
+    int isEmpty = stone != 'O' && stone != 'X';
+    if (wasEmpty != isEmpty) {
+	game->rowStones[r] += isEmpty ? -1 : 1;
+	game->columnStones[c] += isEmpty ? -1 : 1;
+	if (r > 0 && r < game->rows - 1 && c > 0 && c < game->columns - 1) {
+	    update_empty_index(game, r, isEmpty ? 1 : -1);
+	}
+    }
+
+    /* Clear the cell in both layouts, then set the bit of the player who now
+     * occupies it */
+    *wordO &= ~bit;
+    *wordX &= ~bit;
+    *columnWordO &= ~columnBit;
+    *columnWordX &= ~columnBit;
+    if (stone == 'O') {
+	*wordO |= bit;
+	*columnWordO |= columnBit;
+    } else if (stone == 'X') {
+	*wordX |= bit;
+	*columnWordX |= columnBit;
+    }
+}
+
+void update_empty_index(Game* game, long int r, int change) {
+    game->emptyCells += change;
+    game->rowEmpties[r] += change;
+
+    // Only the first empty cell and the last empty cell change the row's bit
+    if (game->rowEmpties[r] == 0) {
+	game->emptyRows[r / WORD_BITS] &= ~CELL_BIT(r);
+    } else if (game->rowEmpties[r] == 1 && change > 0) {
+	game->emptyRows[r / WORD_BITS] |= CELL_BIT(r);
+    }
+}
+
+char* render_row(Game* game, long int r, char* out) {
+    for (long int c = 0; c < game->columns; c++) {
+	// Corners are displayed as two blank spaces
+	if ((r == 0 || r == game->rows - 1) &&
+		(c == 0 || c == game->columns - 1)) {
+	    *out++ = ' ';
+	    *out++ = ' ';
+	} else {
+	    *out++ = '0' + SCORE_AT(r, c);
+	    *out++ = cell_at(game, r, c);
+	}
+    }
+    *out++ = '\n';
+    return out;
+}
+
+char* render_binary(Game* game, char* out) {
+    // Header, see BINARY_HEADER_SIZE
+    memcpy(out, BINARY_MAGIC, BINARY_MAGIC_SIZE);
+    out += BINARY_MAGIC_SIZE;
+    *out++ = BINARY_VERSION;
+    *out++ = game->currentPlayer;
+    *out++ = 0;
+    *out++ = 0;
+    out = write_binary_u32(out, (uint32_t)game->rows);
+    out = write_binary_u32(out, (uint32_t)game->columns);
+    out = write_binary_u64(out, game->key);
+
+    // Score grid then cell states, both packed in row-major order
+    uint64_t cells = (uint64_t)game->rows * game->columns;
+    unsigned char* scores = (unsigned char*)out;
+    unsigned char* states = scores + BINARY_SCORES_SIZE(cells);
+    memset(scores, 0, BINARY_SCORES_SIZE(cells) + BINARY_STATES_SIZE(cells));
+    uint64_t i = 0;
+    for (long int r = 0; r < game->rows; r++) {
+	for (long int c = 0; c < game->columns; c++, i++) {
+	    char stone = cell_at(game, r, c);
+	    int state = (stone == 'O') ? CELL_O :
+		    (stone == 'X') ? CELL_X : CELL_EMPTY;
+	    scores[i / 2] |= SCORE_AT(r, c) << (4 * (i % 2));
+	    states[i / 4] |= state << (2 * (i % 4));
+	}
+    }
+    return (char*)states + BINARY_STATES_SIZE(cells);
+}
+
+char* render_board(Game* game, char* out) {
+    for (long int r = 0; r < game->rows; r++) {
+	out = render_row(game, r, out);
+    }
+    return out;
+}
+
+void print_frame(Game* game, char player) {
+    // Nothing at all is displayed (so stdout needn't be touched)
+    if (game->verbosity == VERBOSITY_NONE) {
+	return;
+    }
+
+    char* out = game->frame;
+    int automated = (player == 'O' && game->playerTypeO != 'H') ||
+	    (player == 'X' && game->playerTypeX != 'H');
+
+    /* Moves made by automated players are always displayed (unless only the
+     * result is displayed), moves made by humans only when the moves are all
+     * that is displayed */
+    if (game->verbosity == VERBOSITY_DELTA) {
+	out = player ? render_delta(game, out, player) :
+		render_full_frame(game, out);
+    } else if (player && ((automated &&
+	    game->verbosity < VERBOSITY_RESULT) ||
+	    game->verbosity == VERBOSITY_MOVES)) {
+	out += sprintf(out, "Player %c placed at %ld %ld\n", player,
+		game->rowMove, game->columnMove);
+    }
+    if (game->verbosity == VERBOSITY_FRAMES) {
+	out = render_board(game, out);
+    }
+
+    // Display the whole frame at once
+    fwrite(game->frame, 1, out - game->frame, stdout);
+}
+
+char* render_full_frame(Game* game, char* out) {
+    out += sprintf(out, "F %ld %ld\n", game->rows, game->columns);
+    return render_board(game, out);
+}
+
+char* render_delta(Game* game, char* out, char player) {
+    out += sprintf(out, "%c %ld %ld", player, game->rowMove,
+	    game->columnMove);
+
+    // A push changes the whole of the line it pushed along
+    PushDirection push = push_direction(game);
+    if (push == PUSH_UP || push == PUSH_DOWN) {
+	*out++ = ' ';
+	for (long int r = 0; r < game->rows; r++) {
+	    *out++ = cell_at(game, r, game->columnMove);
+	}
+    } else if (push == PUSH_LEFT || push == PUSH_RIGHT) {
+	*out++ = ' ';
+	for (long int c = 0; c < game->columns; c++) {
+	    *out++ = cell_at(game, game->rowMove, c);
+	}
+    }
+    *out++ = '\n';
+    return out;
+}
+
+int check_board_full(Game* game) {
+    // The empty cell index counts the empty interior cells
+    return game->emptyCells ? EXIT_NORMAL : EXIT_FULL_BOARD;
+}
+
+void play_game(Game* game, ExitCodes* exitStatus, int* eofFlag) {
+    // Print the game board
+    print_frame(game, 0);
+
+    char* rowMoveErrors = 0;
+    char* columnMoveErrors = 0;
+
+    // Play game until interior is full, at this point the game is over
+    do {
+	// Calculate the appropriate move
+	game_move(&rowMoveErrors, &columnMoveErrors, game, exitStatus,
+		eofFlag);
+	/* Handle EOF on stdin when input required. The necessary stderr
+	 * message is handled already in game_move in the situation of a valid
+	 * human move followed by EOF. */
+	if (*exitStatus == EXIT_EOF) {
+	    if (!(*eofFlag)) {
+		fprintf(stderr, "End of file\n");	
+	    }
+	    game_free_memory(game);
+	    return;
+	}
+
+	// Execute the move decided by game_move
+	play_move(rowMoveErrors, columnMoveErrors, game);
+    } while(!check_board_full(game));
+}
+
+void game_move(char** rowMoveErrors, char** columnMoveErrors, Game* game,
+	ExitCodes* exitStatus, int* eofFlag) {
+
+    /* Tablebase and Solved Moves - Automated players other than type 0 play
+     * the move from the tablebase, or play exactly once few enough cells are
+     * empty, if asked to. */
+    char playerType = (game->currentPlayer == 'O') ? game->playerTypeO :
+	    game->playerTypeX;
+    if (playerType == '1' || playerType == '2' || playerType == '3') {
+	if (tablebase_move(game)) {
+	    *rowMoveErrors = *columnMoveErrors = "";
+	    return;
+	} else if (game->options.solveCells &&
+		remaining_moves(game) <= game->options.solveCells) {
+	    solve_move(rowMoveErrors, columnMoveErrors, game);
+	    return;
+	}
+    }
+
+    /* Type 0 Moves - Ensure this only executes if the current player is a
+     * type 0 player. */
+    if ((game->currentPlayer == 'O' && game->playerTypeO == '0') ||
+	    (game->currentPlayer == 'X' && game->playerTypeX == '0')) {
+	type_zero_move(rowMoveErrors, columnMoveErrors, game);
+	return;
+    }
+     
+    /* Type 2 Moves - Ensure this only executes if the current player is a
+     * type 2 player. */
+    if ((game->currentPlayer == 'O' && game->playerTypeO == '2') ||
+	    (game->currentPlayer == 'X' && game->playerTypeX == '2')) {
+	type_two_move(rowMoveErrors, columnMoveErrors, game);
+	return;
+    }
+
+    /* Type 3 Moves - Ensure this only executes if the current player is a
+     * type 3 player. */
+    if ((game->currentPlayer == 'O' && game->playerTypeO == '3') ||
+	    (game->currentPlayer == 'X' && game->playerTypeX == '3')) {
+	type_three_move(rowMoveErrors, columnMoveErrors, game);
+	return;
+    }
+
+    /* Type 1 Moves - Ensure this only executes if the current player is a
+     * type 1 player. */
+    char opponent = (game->currentPlayer == 'X') ? 'O' : 'X';
+    if ((game->currentPlayer == 'O' && game->playerTypeO == '1') ||
 	    (game->currentPlayer == 'X' && game->playerTypeX == '1')) {
-	type_one_move(game, opponent, move, rowMoveErrors,
+	type_one_move(game, opponent, rowMoveErrors, columnMoveErrors);
+	return;
+    }
+
+    /* Human Moves - As the player types have already been validated, checking
+     * if the current player is of type H is unnecessary as automated player
+     * moves have been handled and the function will not reach this point if
+     * the current player is automated. Below either prompts the user for
+     * their next move, or fprints the appropriate message to stderr if a
+     * valid move was followed by EOF. */
+    if (!(*eofFlag)) {
+	printf("%c:(R C)> ", game->currentPlayer);
+    } else {
+	fprintf(stderr, "%c:(R C)> %s", game->currentPlayer, "End of file\n"); 
+    }
+    char* move = read_input_line(&game->input, eofFlag);
+    if (!move) {
+	*exitStatus = EXIT_EOF;
+	return;
+    }
+
+    // Process and validate human move (this includes saving)
+    human_move(move, game, rowMoveErrors, columnMoveErrors, eofFlag);
+}
+
+void play_move(char* rowMoveErrors, char* columnMoveErrors, Game* game) {
+    // Check invalid inputs, out of bound human moves, and illegal moves
+    if (*rowMoveErrors != '\0' || *columnMoveErrors != '\0' ||
+	    game->rowMove < 0 || game->rowMove >= game->rows ||
+	    game->columnMove < 0 || game->columnMove >= game->columns ||
+	    !move_legal(game, game->rowMove, game->columnMove)) {
+	return;
+    }
+
+    char player = game->currentPlayer;
+    Move move = {game->rowMove, game->columnMove, 0, push_direction(game)};
+    Undo undo;
+    make_move(game, &move, &undo);
+    finish_move(game, player);
+}
+
+void make_move(Game* game, const Move* move, Undo* undo) {
+    // Place a stone on an interior cell, or push from a border cell
+    undo->move = *move;
+    if (move->push == PUSH_NONE) {
+	set_cell(game, move->row, move->column, game->currentPlayer);
+    } else {
+	push_move(game, undo);
+    }
+
+    // Swap current player for next move
+    game->currentPlayer = (game->currentPlayer == 'X') ? 'O' : 'X';
+    game->key ^= ZOBRIST_PLAYER_X;
+#ifdef DEBUG
+    verify_state(game);
+#endif
+}
+
+void unmake_move(Game* game, const Undo* undo) {
+    game->currentPlayer = (game->currentPlayer == 'X') ? 'O' : 'X';
+    game->key ^= ZOBRIST_PLAYER_X;
+
+    /* Empty the placed cell, or push the line back the other way (emptying
+     * the cell the push filled, see push_line) */
+    const Move* move = &undo->move;
+    if (move->push == PUSH_NONE) {
+	set_cell(game, move->row, move->column, '.');
+    } else {
+	int isColumn = move->push == PUSH_UP || move->push == PUSH_DOWN;
+	int step = (move->push == PUSH_DOWN || move->push == PUSH_RIGHT) ?
+		-1 : 1;
+	push_line(game, isColumn, isColumn ? move->column : move->row,
+		undo->low, undo->high, step, '.');
+    }
+#ifdef DEBUG
+    verify_state(game);
+#endif
+}
+
+int generate_moves(Game* game, Move* moves) {
+    // There are no moves once the game is over
+    if (check_board_full(game)) {
+	return 0;
+    }
+
+    int moveCount = 0;
+    for (long int r = 0; r < game->rows; r++) {
+	// The top and bottom borders push down and up their columns
+	if (r == 0 || r == game->rows - 1) {
+	    PushDirection push = r ? PUSH_UP : PUSH_DOWN;
+	    for (long int c = 1; c < game->columns - 1; c++) {
+		if (push_legal(game, push, r, c)) {
+		    moves[moveCount++] = (Move){r, c, 0, push};
+		}
+	    }
+	    continue;
+	}
+
+	/* Otherwise a push right from the left border, every empty interior
+	 * cell of the row (taken a word at a time), and a push left from the
+	 * right border */
+	if (push_legal(game, PUSH_RIGHT, r, 0)) {
+	    moves[moveCount++] = (Move){r, 0, 0, PUSH_RIGHT};
+	}
+	for (long int w = 0; game->rowEmpties[r] && w < game->rowWords; w++) {
+	    BoardWord empty = game->interiorMask[w] &
+		    ~(ROW_WORDS_OF(game->stonesO, r)[w] |
+		    ROW_WORDS_OF(game->stonesX, r)[w]);
+	    for (; empty; empty &= empty - 1) {
+		moves[moveCount++] = (Move){r,
+			w * WORD_BITS + __builtin_ctzll(empty), 0, PUSH_NONE};
+	    }
+	}
+	if (push_legal(game, PUSH_LEFT, r, game->columns - 1)) {
+	    moves[moveCount++] = (Move){r, game->columns - 1, 0, PUSH_LEFT};
+	}
+    }
+    return moveCount;
+}
+
+int move_legal(Game* game, long int r, long int c) {
+    int borderRow = r == 0 || r == game->rows - 1;
+    int borderColumn = c == 0 || c == game->columns - 1;
+    if (borderRow && borderColumn) {
+	return 0;
+    } else if (!borderRow && !borderColumn) {
+	return cell_at(game, r, c) == '.';
+    }
+
+    // Same order as push_direction
+    return push_legal(game, (r == game->rows - 1) ? PUSH_UP :
+	    (r == 0) ? PUSH_DOWN : (c == game->columns - 1) ? PUSH_LEFT :
+	    PUSH_RIGHT, r, c);
+}
+
+int push_legal(Game* game, PushDirection push, long int r, long int c) {
+    if (cell_at(game, r, c) != '.') {
+	return 0;
+    }
+
+    /* The border cell is empty, so there is an empty cell to push into if
+     * any of the other cells of the line are empty */
+    switch (push) {
+	case PUSH_UP:
+	    return cell_at(game, r - 1, c) != '.' &&
+		    game->columnStones[c] < game->rows - 1;
+	case PUSH_DOWN:
+	    return cell_at(game, r + 1, c) != '.' &&
+		    game->columnStones[c] < game->rows - 1;
+	case PUSH_LEFT:
+	    return cell_at(game, r, c - 1) != '.' &&
+		    game->rowStones[r] < game->columns - 1;
+	case PUSH_RIGHT:
+	    return cell_at(game, r, c + 1) != '.' &&
+		    game->rowStones[r] < game->columns - 1;
+	default:
+	    return 0;
+    }
+}
+
+void run_perft(Game* game) {
+    game->searchMoves = (Move*)malloc(game->options.perftDepth *
+	    MOVE_CAPACITY * sizeof(Move));
+    game->verbosity = VERBOSITY_NONE;
+    for (int depth = 1; depth <= game->options.perftDepth; depth++) {
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	long int nodes = perft(game, depth, 0);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec) +
+		(end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("%d %ld\n", depth, nodes);
+	fflush(stdout);
+	fprintf(stderr, "Perft %d: %ld nodes in %.3f s (%.0f nodes/s)\n",
+		depth, nodes, seconds, seconds > 0 ? nodes / seconds : 0.0);
+    }
+}
+
+long int perft(Game* game, int depth, int ply) {
+    Move* moves = game->searchMoves + ply * MOVE_CAPACITY;
+    int moveCount = generate_moves(game, moves);
+#ifdef DEBUG
+    // Every move generated must be legal, and every legal move generated
+    long int legalCount = 0;
+    for (long int r = 0; r < game->rows && !check_board_full(game); r++) {
+	for (long int c = 0; c < game->columns; c++) {
+	    legalCount += move_legal(game, r, c);
+	}
+    }
+    for (int i = 0; i < moveCount; i++) {
+	legalCount -= move_legal(game, moves[i].row, moves[i].column);
+    }
+    if (legalCount) {
+	fprintf(stderr, "Generated moves differ from legal moves\n");
+	abort();
+    }
+#endif
+    if (depth == 1) {
+	return moveCount;
+    }
+
+    long int nodes = 0;
+    for (int i = 0; i < moveCount; i++) {
+	Undo undo;
+	make_move(game, &moves[i], &undo);
+	nodes += perft(game, depth - 1, ply + 1);
+	unmake_move(game, &undo);
+    }
+    return nodes;
+}
+
+void run_bench(Game* game) {
+    // The kernels are run over the board as it would be saved
+    long int rowLength = 2 * game->columns + 1;
+    char* text = (char*)malloc(game->rows * rowLength);
+    render_board(game, text);
+    uint8_t* scores = (uint8_t*)malloc(SCORE_STRIDE);
+    BoardWord* cells = (BoardWord*)malloc(2 * game->rowWords *
+	    sizeof(BoardWord));
+
+    // The scalar kernels are last, and are run first to check the others
+    int count;
+    const Kernels* kernels = kernels_list(&count);
+    long int expected = 0;
+    for (int k = count - 1; k >= 0; k--) {
+	if (!kernels_supported(&kernels[k])) {
+	    fprintf(stderr, "Kernels %s: not supported\n", kernels[k].name);
+	    continue;
+	}
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	long int checksum = 0;
+	for (long int pass = 0; pass < game->options.benchPasses; pass++) {
+	    checksum += bench_pass(game, &kernels[k], text, scores, cells);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec) +
+		(end.tv_nsec - start.tv_nsec) / 1e9;
+	if (k == count - 1) {
+	    expected = checksum;
+	}
+	fprintf(stderr, "Kernels %s: %ld passes in %.3f s (%.0f MB/s)%s\n",
+		kernels[k].name, game->options.benchPasses, seconds,
+		seconds > 0 ? game->options.benchPasses * game->rows *
+		rowLength / seconds / 1e6 : 0.0,
+		checksum != expected ? ", results differ" : "");
+    }
+    free(text);
+    free(scores);
+    free(cells);
+}
+
+long int bench_pass(Game* game, const Kernels* kernels, const char* text,
+	uint8_t* scores, BoardWord* cells) {
+    long int checksum = 0;
+    for (long int r = 0; r < game->rows; r++) {
+	const char* row = text + r * (2 * game->columns + 1);
+	int border = r == 0 || r == game->rows - 1;
+	checksum += kernels->textValid(row + 2, 2 * game->columns - 4,
+		border ? '0' : '1', border ? '0' : '9');
+	kernels->decodeScores(row, game->columns, scores);
+	memset(cells, 0, 2 * game->rowWords * sizeof(BoardWord));
+	kernels->decodeStones(row, game->columns, cells,
+		cells + game->rowWords);
+	checksum += 3 * kernels->sumScores(scores, cells, game->rowWords) +
+		kernels->sumScores(scores, cells + game->rowWords,
+		game->rowWords);
+    }
+    return checksum;
+}
+
+void type_zero_move(char** rowMoveErrors, char** columnMoveErrors,
+	Game* game) {
+    long int r, w;
+    BoardWord empty = 0;
+
+    /* Handle player O type 0 moves; take the first cell of the board (top to
+     * bottom, left to right) that is empty. The lowest bit of the empty rows
+     * is the top row with an empty cell, and the lowest empty bit of said row
+     * is its leftmost empty cell. */
+    if (game->currentPlayer == 'O' && game->playerTypeO == '0') {
+	for (w = 0; !game->emptyRows[w]; w++) {
+	}
+	r = w * WORD_BITS + __builtin_ctzll(game->emptyRows[w]);
+	for (w = 0; !empty; w++) {
+	    empty = game->interiorMask[w] &
+		    ~(ROW_WORDS_OF(game->stonesO, r)[w] |
+		    ROW_WORDS_OF(game->stonesX, r)[w]);
+	}
+	game->rowMove = r;
+	game->columnMove = (w - 1) * WORD_BITS + __builtin_ctzll(empty);
+
+	// Set errors to == '\0' so that play_move can process the move
+	*rowMoveErrors = *columnMoveErrors = "";
+    } else if(game->currentPlayer == 'X' && game->playerTypeX == '0') {
+	/* Handle player X type 0 moves; take the last cell of the board (i.e.
+	 * bottom to top, right to left) that is empty, using the highest bits
+	 * instead. */
+	for (w = (game->rows - 1) / WORD_BITS; !game->emptyRows[w]; w--) {
+	}
+	r = w * WORD_BITS + WORD_BITS - 1 -
+		__builtin_clzll(game->emptyRows[w]);
+	for (w = game->rowWords - 1; !empty; w--) {
+	    empty = game->interiorMask[w] &
+		    ~(ROW_WORDS_OF(game->stonesO, r)[w] |
+		    ROW_WORDS_OF(game->stonesX, r)[w]);
+	}
+	game->rowMove = r;
+	game->columnMove = (w + 1) * WORD_BITS + WORD_BITS - 1 -
+		__builtin_clzll(empty);
+	*rowMoveErrors = *columnMoveErrors = "";
+    }
+}
+
+void type_one_move(Game* game, char opponent, char** rowMoveErrors,
+	char** columnMoveErrors) {
+    Move move = type_one_sweep(game, opponent);
+#ifdef DEBUG
+    // Cross-check the sweep against evaluating each legal move in turn
+    type_one_reference(game, opponent, rowMoveErrors, columnMoveErrors);
+    if (game->rowMove != move.row || game->columnMove != move.column) {
+	fprintf(stderr, "Type one sweep chose %ld %ld, the moves give %ld "
+		"%ld\n", (long int)move.row, (long int)move.column,
+		game->rowMove, game->columnMove);
+	abort();
+    }
+#endif
+    game->rowMove = move.row;
+    game->columnMove = move.column;
+
+    // Set errors to == '\0' so that play_move can process the move
+    *rowMoveErrors = *columnMoveErrors = "";
+}
+
+Move type_one_sweep(Game* game, char opponent) {
+    BoardWord* stones = (opponent == 'O') ? game->stonesO : game->stonesX;
+    long int last = game->rows - 1;
+
+    /* A column can only be pushed along if both of its border cells are
+     * empty, and a stone is next to one of them */
+    ColumnSums* columnSums = game->columnSums;
+    BoardWord* pushColumns = game->pushColumns;
+    for (long int w = 0; w < game->rowWords; w++) {
+	BoardWord top = ROW_WORDS_OF(game->stonesO, 0)[w] |
+		ROW_WORDS_OF(game->stonesX, 0)[w];
+	BoardWord bottom = ROW_WORDS_OF(game->stonesO, last)[w] |
+		ROW_WORDS_OF(game->stonesX, last)[w];
+	BoardWord next = ROW_WORDS_OF(game->stonesO, 1)[w] |
+		ROW_WORDS_OF(game->stonesX, 1)[w] |
+		ROW_WORDS_OF(game->stonesO, last - 1)[w] |
+		ROW_WORDS_OF(game->stonesX, last - 1)[w];
+	pushColumns[w] = game->interiorMask[w] & ~top & ~bottom & next;
+    }
+    for (long int c = 1; c < game->columns - 1; c++) {
+	columnSums[c] = (ColumnSums){{0, 0}, {0, 0}, 1};
+    }
+
+    Move left = {-1, game->columns - 1, 0, PUSH_LEFT};
+    Move right = {-1, 0, 0, PUSH_RIGHT};
+    Move first = {-1, -1, 0, PUSH_NONE};
+    Move higher = {-1, -1, 0, PUSH_NONE};
+    Move highest = {1, 1, 0, PUSH_NONE};
+    int maxScore = 0;
+    if (cell_at(game, 1, 1) == '.') {
+	maxScore = SCORE_AT(1, 1); // Set to first cell if empty
+    }
+    for (long int r = 1; r < last; r++) {
+	/* The row's stones reachable from the left border, and its stones
+	 * since the last empty cell (i.e. reachable from the right border
+	 * once the row is done), which are only needed if the row can be
+	 * pushed along */
+	LineSums rightSums = {0, 0};
+	LineSums leftSums = {0, 0};
+	int reachable = 1;
+	int pushRow = cell_at(game, r, 0) == '.' &&
+		cell_at(game, r, game->columns - 1) == '.' &&
+		(cell_at(game, r, 1) != '.' ||
+		cell_at(game, r, game->columns - 2) != '.');
+	for (long int w = 0; w < game->rowWords; w++) {
+	    BoardWord empty = game->interiorMask[w] &
+		    ~(ROW_WORDS_OF(game->stonesO, r)[w] |
+		    ROW_WORDS_OF(game->stonesX, r)[w]);
+	    BoardWord lines = pushRow ? game->interiorMask[w] :
+		    pushColumns[w];
+	    BoardWord visit = empty | (ROW_WORDS_OF(stones, r)[w] & lines);
+	    for (; visit; visit &= visit - 1) {
+		long int c = w * WORD_BITS + __builtin_ctzll(visit);
+		ColumnSums* column = &columnSums[c];
+		int score = SCORE_AT(r, c);
+		if (!(empty & CELL_BIT(c))) {
+		    if (pushRow && reachable) {
+			rightSums.score += score;
+			rightSums.pushed += SCORE_AT(r, c + 1);
+		    }
+		    if (pushRow) {
+			leftSums.score += score;
+			leftSums.pushed += SCORE_AT(r, c - 1);
+		    }
+		    if (!(pushColumns[w] & CELL_BIT(c))) {
+			continue;
+		    }
+		    if (column->reachable) {
+			column->down.score += score;
+			column->down.pushed += SCORE_AT(r + 1, c);
+		    }
+		    column->up.score += score;
+		    column->up.pushed += SCORE_AT(r - 1, c);
+		    continue;
+		}
+
+		// An empty cell ends every line reaching it
+		reachable = column->reachable = 0;
+		leftSums = column->up = (LineSums){0, 0};
+
+		/* Keep the first empty cell, the first cell worth more than
+		 * the first interior cell, and the highest valued cell */
+		if (first.row < 0) {
+		    first.row = r;
+		    first.column = c;
+		}
+		if (maxScore < score) {
+		    if (higher.row < 0) {
+			higher.row = r;
+			higher.column = c;
+		    }
+		    highest.row = r;
+		    highest.column = c;
+		    maxScore = score;
+		}
+	    }
+	}
+	if (pushRow && left.row < 0 && type_one_push_lowers(game, PUSH_LEFT,
+		r, game->columns - 1, leftSums)) {
+	    left.row = r;
+	}
+	if (pushRow && type_one_push_lowers(game, PUSH_RIGHT, r, 0,
+		rightSums)) {
+	    right.row = r;
+	}
+    }
+
+    // Take the first move found in the order specified in the spec
+    for (long int c = 1; c < game->columns - 1; c++) {
+	if (type_one_push_lowers(game, PUSH_DOWN, 0, c,
+		columnSums[c].down)) {
+	    return (Move){0, c, 0, PUSH_DOWN};
+	}
+    }
+    if (left.row >= 0) {
+	return left;
+    }
+    for (long int c = game->columns - 2; c > 0; c--) {
+	if (type_one_push_lowers(game, PUSH_UP, last, c,
+		columnSums[c].up)) {
+	    return (Move){last, c, 0, PUSH_UP};
+	}
+    }
+    if (right.row >= 0) {
+	return right;
+    }
+
+    /* When tied only the first cell worth more than the first interior cell
+     * is taken (or the first cell if all cells are of equal value) */
+    if (game->scoreO == game->scoreX) {
+	return (higher.row >= 0) ? higher : first;
+    }
+    return highest;
+}
+
+int type_one_push_lowers(Game* game, PushDirection push, long int r,
+	long int c, LineSums sums) {
+    int vertical = push == PUSH_UP || push == PUSH_DOWN;
+    return sums.pushed < sums.score && push_legal(game, push, r, c) &&
+	    cell_at(game, vertical ? game->rows - 1 - r : r,
+	    vertical ? c : game->columns - 1 - c) == '.';
+}
+
+#ifdef DEBUG
+void type_one_reference(Game* game, char opponent, char** rowMoveErrors,
+	char** columnMoveErrors) {
+    /* This conditional essentially checks each type one move in the order
+     * specified in the spec until a valid move is found. */
+    int moveCount = generate_moves(game, game->moves);
+    if (type_one_push(game, opponent, moveCount, PUSH_DOWN, rowMoveErrors,
+	    columnMoveErrors)) {
+	return;
+    } else if (type_one_push(game, opponent, moveCount, PUSH_LEFT,
+	    rowMoveErrors, columnMoveErrors)) {
+	return;
+    } else if (type_one_push(game, opponent, moveCount, PUSH_UP,
+	    rowMoveErrors, columnMoveErrors)) {
+	return;
+    } else if (type_one_push(game, opponent, moveCount, PUSH_RIGHT,
+	    rowMoveErrors, columnMoveErrors)) {
+	return;
+    } else {
+	type_one_highest_cell(game, moveCount, rowMoveErrors,
 		columnMoveErrors);
+    }
+}
+
+int type_one_push(Game* game, char opponent, int moveCount,
+	PushDirection direction, char** rowMoveErrors,
+	char** columnMoveErrors) {
+    /* The moves are in board order, so pushes up and pushes right are
+     * checked from the last move backwards */
+    int backwards = direction == PUSH_UP || direction == PUSH_RIGHT;
+    long int rowStep = (direction == PUSH_DOWN) ? 1 :
+	    (direction == PUSH_UP) ? -1 : 0;
+    long int columnStep = (direction == PUSH_RIGHT) ? 1 :
+	    (direction == PUSH_LEFT) ? -1 : 0;
+    for (int i = 0; i < moveCount; i++) {
+	Move* move = &game->moves[backwards ? moveCount - 1 - i : i];
+
+	/* Ensure pushing rules are met (the push is legal, and the border
+	 * cell at the other end of the line is empty) */
+	if (move->push != direction || cell_at(game,
+		rowStep ? game->rows - 1 - move->row : move->row,
+		columnStep ? game->columns - 1 - move->column :
+		move->column) != '.') {
+	    continue;
+	}
+
+	/* Calculate score of both players that is contributed to by the cells
+	 * in the line, and check what these scores would be if a pushing
+	 * cells move was made */
+	int scoreLine = 0;
+	int scorePush = 0;
+	for (long int r = move->row + rowStep, c = move->column + columnStep;
+		r > 0 && r < game->rows - 1 && c > 0 && c < game->columns - 1;
+		r += rowStep, c += columnStep) {
+	    char stone = cell_at(game, r, c);
+	    if (stone == opponent) {
+		scoreLine += SCORE_AT(r, c);
+		scorePush += SCORE_AT(r + rowStep, c + columnStep);
+	    } else if (stone == '.') {
+		break;
+	    }
+	}
+	if (scorePush < scoreLine) {
+	    game->rowMove = move->row;
+	    game->columnMove = move->column;
+
+	    // Set errors to == '\0' so that play_move can process the move
+	    *rowMoveErrors = *columnMoveErrors = "";
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+void type_one_highest_cell(Game* game, int moveCount, char** rowMoveErrors,
+	char** columnMoveErrors) {
+    int currentScoreO = game->scoreO;
+    int currentScoreX = game->scoreX;
+    long int maxRow = 1;
+    long int maxColumn = 1;
+    long int firstRow = -1;
+    long int firstColumn = -1;
+
+    int maxScore = 0;
+    if (cell_at(game, 1, 1) == '.') {
+	maxScore = SCORE_AT(1, 1); // Set to first cell if empty
+    }
+    /* Iterate through the empty cells (in board order) and find highest
+     * valued cell */
+    for (int i = 0; i < moveCount; i++) {
+	Move* move = &game->moves[i];
+	if (move->push != PUSH_NONE) {
+	    continue;
+	}
+	if (firstRow < 0) {
+	    firstRow = move->row;
+	    firstColumn = move->column;
+	}
+	if (maxScore < SCORE_AT(move->row, move->column)) {
+	    maxRow = move->row;
+	    maxColumn = move->column;
+	    maxScore = SCORE_AT(maxRow, maxColumn);
+	    if (currentScoreO == currentScoreX) {
+		game->rowMove = maxRow;
+		game->columnMove = maxColumn;
+		/* Set errors to '/0' so that play_move processes *move */
+		*rowMoveErrors = *columnMoveErrors = "";
+		return;
+	    }
+	}
+    }
+    // For case when tied but all cells of equal value, take the first cell
+    if (currentScoreO == currentScoreX) {
+	game->rowMove = firstRow;
+	game->columnMove = firstColumn;
+	*rowMoveErrors = *columnMoveErrors = "";
+	return;
+    }
+    /* This last block handles normal situation without ties (if no cell is
+     * worth more than the first cell, then the first cell is the move) */
+    game->rowMove = maxRow;
+    game->columnMove = maxColumn;
+    *rowMoveErrors = *columnMoveErrors = "";
+    return;
+}
+#endif
+
+void type_two_move(char** rowMoveErrors, char** columnMoveErrors,
+	Game* game) {
+    /* Only searches against the clock are helped, as the helpers would
+     * change the result of a fixed depth search (through the shared table) */
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int helped = game->options.moveTimeMs && game->options.threads > 1 &&
+	    start_helpers(game);
+    int completed = 0;
+    if (game->options.moveTimeMs) {
+	completed = timed_search(game);
+    } else {
+	int depth = game->options.searchDepth ? game->options.searchDepth :
+		SEARCH_DEPTH;
+	search_tables(game, depth);
+
+	// The search makes (and unmakes) moves without displaying them
+	long int row, column;
+	negamax(game, depth, -SEARCH_INFINITY, SEARCH_INFINITY, 0, &row,
+		&column);
+	game->rowMove = row;
+	game->columnMove = column;
+    }
+    if (helped) {
+	stop_helpers(game);
+    }
+
+    /* A timed move takes as long as starting and stopping the helpers as
+     * well as the search itself */
+    if (game->options.moveTimeMs) {
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec) +
+		(end.tv_nsec - start.tv_nsec) / 1e9;
+	game->stats.timedMoves++;
+	game->stats.timedDepths += completed;
+	game->stats.timedSeconds += seconds;
+	if (seconds > game->stats.timedSlowest) {
+	    game->stats.timedSlowest = seconds;
+	}
+	if (game->verbosity == VERBOSITY_MOVES) {
+	    fprintf(stderr, "Player %c searched to depth %d in %.3f s\n",
+		    game->currentPlayer, completed, seconds);
+	}
+    }
+
+    // Set errors to == '\0' so that play_move can process the move
+    *rowMoveErrors = *columnMoveErrors = "";
+}
+
+int start_helpers(Game* game) {
+    if (!game->helperPool) {
+	/* The game's own thread searches as it would alone, so there is one
+	 * helper fewer than threads (or as many as could be started). Without
+	 * the memory for the table or the helpers, it searches alone. */
+	SharedTable* table = (SharedTable*)calloc(1, sizeof(SharedTable));
+	HelperPool* pool = (HelperPool*)calloc(1, sizeof(HelperPool));
+	if (table) {
+	    table->words = (uint64_t*)calloc(TABLE_SIZE * TABLE_WORDS,
+		    sizeof(uint64_t));
+	}
+	if (pool) {
+	    pool->helpers = (Helper*)calloc(game->options.threads - 1,
+		    sizeof(Helper));
+	}
+	if (!table || !table->words || !pool || !pool->helpers) {
+	    if (table) {
+		free(table->words);
+	    }
+	    if (pool) {
+		free(pool->helpers);
+	    }
+	    free(table);
+	    free(pool);
+	    return 0;
+	}
+	game->sharedTable = table;
+	pthread_mutex_init(&pool->lock, 0);
+	pthread_cond_init(&pool->start, 0);
+	pthread_cond_init(&pool->done, 0);
+	game->helperPool = pool;
+	for (int t = 0; t < game->options.threads - 1; t++) {
+	    Helper* helper = &pool->helpers[t];
+	    helper->game = copy_game(game);
+	    if (!helper->game) {
+		break;
+	    }
+	    helper->game->sharedTable = game->sharedTable;
+	    helper->game->stopFlag = &pool->stopFlag;
+	    helper->game->deadlineSet = 0;
+	    helper->firstDepth = 1 + (t + 1) % 2;
+	    helper->pool = pool;
+	    if (pthread_create(&helper->thread, 0, helper_thread, helper)) {
+		helper->game->sharedTable = 0;
+		game_free_memory(helper->game);
+		break;
+	    }
+	    pool->helperCount++;
+	}
+    }
+    game->sharedTable->age++;
+
+    // Bring every copy up to the game's position, then wake the helpers
+    HelperPool* pool = game->helperPool;
+    for (int t = 0; t < pool->helperCount; t++) {
+	Game* copy = pool->helpers[t].game;
+	memcpy(copy->stonesO, game->stonesO, game->arenaSize);
+	copy->scoreO = game->scoreO;
+	copy->scoreX = game->scoreX;
+	copy->emptyCells = game->emptyCells;
+	copy->currentPlayer = game->currentPlayer;
+	copy->key = game->key;
+	copy->moveCount = game->moveCount;
+	copy->searchNodes = 0;
+	copy->searchStopped = 0;
+    }
+    pthread_mutex_lock(&pool->lock);
+    __atomic_store_n(&pool->stopFlag, 0, __ATOMIC_RELAXED);
+    pool->generation++;
+    pool->busy = pool->helperCount;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    return 1;
+}
+
+void stop_helpers(Game* game) {
+    HelperPool* pool = game->helperPool;
+    __atomic_store_n(&pool->stopFlag, 1, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy) {
+	pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    for (int t = 0; t < pool->helperCount; t++) {
+	game->stats.timedNodes += pool->helpers[t].game->searchNodes;
+    }
+}
+
+void free_helpers(Game* game) {
+    HelperPool* pool = game->helperPool;
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int t = 0; t < pool->helperCount; t++) {
+	pthread_join(pool->helpers[t].thread, 0);
+
+	// The shared table is the game's, and freed with it
+	pool->helpers[t].game->sharedTable = 0;
+	game_free_memory(pool->helpers[t].game);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->helpers);
+    free(pool);
+    game->helperPool = 0;
+}
+
+void* helper_thread(void* argument) {
+    Helper* helper = (Helper*)argument;
+    HelperPool* pool = helper->pool;
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+	while (!pool->quit && helper->generation == pool->generation) {
+	    pthread_cond_wait(&pool->start, &pool->lock);
+	}
+	if (pool->quit) {
+	    break;
+	}
+	helper->generation = pool->generation;
+	pthread_mutex_unlock(&pool->lock);
+	helper_search(helper);
+	pthread_mutex_lock(&pool->lock);
+	if (!--pool->busy) {
+	    pthread_cond_signal(&pool->done);
+	}
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+void helper_search(Helper* helper) {
+    Game* game = helper->game;
+    int maxDepth = remaining_moves(game);
+    if (maxDepth > INT16_MAX) {
+	maxDepth = INT16_MAX;
+    }
+    for (int depth = helper->firstDepth;
+	    depth <= maxDepth && !game->searchStopped; depth++) {
+	search_tables(game, depth);
+	long int row, column;
+	negamax(game, depth, -SEARCH_INFINITY, SEARCH_INFINITY, 0, &row,
+		&column);
+    }
+}
+
+int timed_search(Game* game) {
+    /* Search no deeper than asked for, or than the end of the game (the
+     * depth of an entry in the transposition table being limited to
+     * INT16_MAX) */
+    int maxDepth = remaining_moves(game);
+    if (game->options.searchDepth && game->options.searchDepth < maxDepth) {
+	maxDepth = game->options.searchDepth;
+    }
+    if (maxDepth > INT16_MAX) {
+	maxDepth = INT16_MAX;
+    }
+
+    set_deadline(&game->deadline, game->options.moveTimeMs);
+    game->deadlineSet = 1;
+    game->searchStopped = 0;
+    long int nodes = game->searchNodes;
+    int completed = 0;
+    for (int depth = 1; depth <= maxDepth; depth++) {
+	search_tables(game, depth);
+	long int row, column;
+	negamax(game, depth, -SEARCH_INFINITY, SEARCH_INFINITY, 0, &row,
+		&column);
+
+	/* Out of time before the first search was completed, take the best
+	 * move it found, or failing that the most promising move (the moves
+	 * at the root being left in order) */
+	if (game->searchStopped && !completed) {
+	    game->rowMove = (row >= 0) ? row : game->searchMoves[0].row;
+	    game->columnMove =
+		    (row >= 0) ? column : game->searchMoves[0].column;
+	}
+	if (game->searchStopped) {
+	    break;
+	}
+	game->rowMove = row;
+	game->columnMove = column;
+	completed = depth;
+    }
+    game->deadlineSet = game->searchStopped = 0;
+    game->stats.timedNodes += game->searchNodes - nodes;
+    return completed;
+}
+
+void search_tables(Game* game, int plies) {
+    if (!game->table && !game->sharedTable) {
+	game->table = (TableEntry*)calloc(TABLE_SIZE, sizeof(TableEntry));
+    }
+    if (plies > game->searchPlies) {
+	free(game->searchMoves);
+	game->searchMoves =
+		(Move*)malloc(plies * MOVE_CAPACITY * sizeof(Move));
+	game->searchPlies = plies;
+    }
+}
+
+void solve_move(char** rowMoveErrors, char** columnMoveErrors, Game* game) {
+    /* Search to the end of the game (the depth of an entry in the
+     * transposition table being limited to INT16_MAX) */
+    int depth = remaining_moves(game);
+    if (depth > INT16_MAX) {
+	depth = INT16_MAX;
+    }
+    search_tables(game, depth);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long int nodes = game->searchNodes;
+    long int row, column;
+    negamax(game, depth, -SEARCH_INFINITY, SEARCH_INFINITY, 0, &row, &column);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) +
+	    (end.tv_nsec - start.tv_nsec) / 1e9;
+    game->stats.solveMoves++;
+    game->stats.solveNodes += game->searchNodes - nodes;
+    game->stats.solveSeconds += seconds;
+    if (seconds > game->stats.solveSlowest) {
+	game->stats.solveSlowest = seconds;
+    }
+    game->rowMove = row;
+    game->columnMove = column;
+
+    // Set errors to == '\0' so that play_move can process the move
+    *rowMoveErrors = *columnMoveErrors = "";
+}
+
+int remaining_moves(Game* game) {
+    // The interior's empty cells, and the border's (of which there are four)
+    long int borderStones = game->rowStones[0] +
+	    game->rowStones[game->rows - 1] + game->columnStones[0] +
+	    game->columnStones[game->columns - 1];
+    return game->emptyCells + 2 * (game->rows + game->columns - 4) -
+	    borderStones;
+}
+
+int make_tablebase(Game* game) {
+    /* Every position is searched to the end of the game, only needing room
+     * for the moves of each ply (and none for a transposition table, the
+     * positions being kept in the tablebase) */
+    int plies = remaining_moves(game);
+    if (plies > TABLEBASE_MAX_MOVES) {
+	fprintf(stderr, "Board too big for a tablebase\n");
+	return EXIT_TABLEBASE;
+    }
+    game->searchMoves = (Move*)malloc((plies + 1) * MOVE_CAPACITY *
+	    sizeof(Move));
+    game->verbosity = VERBOSITY_NONE;
+    Tablebase tablebase;
+    tablebase.slotCount = 1024;
+    tablebase.count = 0;
+    tablebase.failed = 0;
+    tablebase.slots =
+	    (TablebaseSlot*)calloc(tablebase.slotCount, sizeof(TablebaseSlot));
+    if (!game->searchMoves || !tablebase.slots) {
+	fprintf(stderr, "Out of memory for a tablebase\n");
+	free(tablebase.slots);
+	return EXIT_TABLEBASE;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    tablebase_solve(game, &tablebase, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) +
+	    (end.tv_nsec - start.tv_nsec) / 1e9;
+    if (tablebase.failed) {
+	fprintf(stderr, "Out of memory for a tablebase\n");
+	free(tablebase.slots);
+	return EXIT_TABLEBASE;
+    }
+
+    /* Write the header and then the slots (a block of them at a time, as
+     * little endian numbers) */
+    FILE* file = fopen(game->options.tablebaseOut, "w");
+    if (!file) {
+	fprintf(stderr, "Tablebase write failed\n");
+	free(tablebase.slots);
+	return EXIT_TABLEBASE;
+    }
+    char block[TABLEBASE_SLOT_SIZE * 256];
+    memset(block, 0, TABLEBASE_HEADER_SIZE);
+    memcpy(block, TABLEBASE_MAGIC, TABLEBASE_MAGIC_SIZE);
+    block[TABLEBASE_VERSION_OFFSET] = TABLEBASE_VERSION;
+    write_binary_u32(block + TABLEBASE_ROWS_OFFSET, (uint32_t)game->rows);
+    write_binary_u32(block + TABLEBASE_COLUMNS_OFFSET,
+	    (uint32_t)game->columns);
+    write_binary_u64(block + TABLEBASE_KEY_OFFSET, board_key(game));
+    write_binary_u64(block + TABLEBASE_SLOTS_OFFSET, tablebase.slotCount);
+    int written = fwrite(block, 1, TABLEBASE_HEADER_SIZE, file) ==
+	    TABLEBASE_HEADER_SIZE;
+    for (uint64_t i = 0; written && i < tablebase.slotCount; i += 256) {
+	char* out = block;
+	for (uint64_t j = i; j < i + 256 && j < tablebase.slotCount; j++) {
+	    write_binary_u64(out, tablebase.slots[j].key);
+	    write_binary_u32(out + TABLEBASE_SLOT_VALUE_OFFSET,
+		    (uint32_t)tablebase.slots[j].value);
+	    write_binary_u32(out + TABLEBASE_SLOT_MOVE_OFFSET,
+		    tablebase.slots[j].move);
+	    out += TABLEBASE_SLOT_SIZE;
+	}
+	written = fwrite(block, 1, out - block, file) ==
+		(size_t)(out - block);
+    }
+    free(tablebase.slots);
+    if (fclose(file) || !written) {
+	fprintf(stderr, "Tablebase write failed\n");
+	return EXIT_TABLEBASE;
+    }
+    fprintf(stderr, "Tablebase: %" PRIu64 " positions in %.3f s (%.0f "
+	    "positions/s), %" PRIu64 " bytes\n", tablebase.count, seconds,
+	    seconds > 0 ? tablebase.count / seconds : 0.0,
+	    TABLEBASE_HEADER_SIZE + tablebase.slotCount * TABLEBASE_SLOT_SIZE);
+    return EXIT_NORMAL;
+}
+
+int tablebase_solve(Game* game, Tablebase* tablebase, int ply) {
+    // Positions are valued as the score difference for the player to move
+    if (check_board_full(game)) {
+	return (game->currentPlayer == 'O') ?
+		game->scoreO - game->scoreX : game->scoreX - game->scoreO;
+    }
+    TablebaseSlot* slot =
+	    tablebase_slot(tablebase->slots, tablebase->slotCount, game->key);
+    if (slot->key == game->key) {
+	return slot->value;
+    }
+
+    Move* moves = game->searchMoves + ply * MOVE_CAPACITY;
+    int moveCount = generate_moves(game, moves);
+    int best = -SEARCH_INFINITY;
+    uint32_t bestMove = 0;
+    for (int i = 0; i < moveCount; i++) {
+	Undo undo;
+	make_move(game, &moves[i], &undo);
+	int value = -tablebase_solve(game, tablebase, ply + 1);
+	unmake_move(game, &undo);
+	if (value > best) {
+	    best = value;
+	    bestMove = moves[i].row * game->columns + moves[i].column;
+	}
+    }
+
+    /* A key of 0 marks an empty slot, so a position whose key is 0 (which
+     * is vanishingly unlikely) is left out, and searched when played */
+    if (game->key) {
+	tablebase_store(tablebase, game->key, best, bestMove);
+    }
+    return best;
+}
+
+TablebaseSlot* tablebase_slot(TablebaseSlot* slots, uint64_t slotCount,
+	uint64_t key) {
+    uint64_t i = key & (slotCount - 1);
+    while (slots[i].key && slots[i].key != key) {
+	i = (i + 1) & (slotCount - 1);
+    }
+    return &slots[i];
+}
+
+void tablebase_store(Tablebase* tablebase, uint64_t key, int value,
+	uint32_t move) {
+    if (tablebase->failed) {
+	return;
+    }
+    if (2 * (tablebase->count + 1) > tablebase->slotCount) {
+	uint64_t slotCount = 2 * tablebase->slotCount;
+	TablebaseSlot* slots =
+		(TablebaseSlot*)calloc(slotCount, sizeof(TablebaseSlot));
+	if (!slots) {
+	    tablebase->failed = 1;
+	    return;
+	}
+	for (uint64_t i = 0; i < tablebase->slotCount; i++) {
+	    if (tablebase->slots[i].key) {
+		*tablebase_slot(slots, slotCount, tablebase->slots[i].key) =
+			tablebase->slots[i];
+	    }
+	}
+	free(tablebase->slots);
+	tablebase->slots = slots;
+	tablebase->slotCount = slotCount;
+    }
+    TablebaseSlot* slot =
+	    tablebase_slot(tablebase->slots, tablebase->slotCount, key);
+    *slot = (TablebaseSlot){key, value, move};
+    tablebase->count++;
+}
+
+void open_tablebase(Game* game) {
+    if (!load_file(game->options.tablebaseName, &game->tablebase)) {
+	fprintf(stderr, "No tablebase to load from\n");
 	return;
     }
 
-    /* Human Moves - As the player types have already been validated, checking
-     * if the current player is of type H is unnecessary as automated player
-     * moves have been handled and the function will not reach this point if
-     * the current player is automated. Below either prompts the user for
-     * their next move, or fprints the appropriate message to stderr if a
-     * valid move was followed by EOF. */
-    if (!(*eofFlag)) {
-	printf("%c:(R C)> ", game->currentPlayer);
-    } else {
-	fprintf(stderr, "%c:(R C)> %s", game->currentPlayer, "End of file\n"); 
+    /* The header must be whole, and the slots (a power of two of them) must
+     * fill the rest of the file */
+    const unsigned char* header =
+	    (const unsigned char*)game->tablebase.contents;
+    size_t size = game->tablebase.size;
+    uint64_t slots = (size >= TABLEBASE_HEADER_SIZE) ?
+	    read_binary_u64(header + TABLEBASE_SLOTS_OFFSET) : 0;
+    if (size < TABLEBASE_HEADER_SIZE || memcmp(header, TABLEBASE_MAGIC,
+	    TABLEBASE_MAGIC_SIZE) ||
+	    header[TABLEBASE_VERSION_OFFSET] != TABLEBASE_VERSION ||
+	    !slots ||
+	    (slots & (slots - 1)) ||
+	    slots > (size - TABLEBASE_HEADER_SIZE) / TABLEBASE_SLOT_SIZE ||
+	    size != TABLEBASE_HEADER_SIZE + slots * TABLEBASE_SLOT_SIZE) {
+	fprintf(stderr, "Invalid tablebase\n");
+	close_file(&game->tablebase);
+	game->tablebase.contents = 0;
+	return;
     }
-    *move = read_line(stdin, 81, eofFlag);
-    
-    if (!strcmp(*move, "test_EOF")) {	
-	*exitStatus = EXIT_EOF;
+
+    // Tablebases of other boards are left unused
+    if (read_binary_u32(header + TABLEBASE_ROWS_OFFSET) != game->rows ||
+	    read_binary_u32(header + TABLEBASE_COLUMNS_OFFSET) !=
+	    game->columns ||
+	    read_binary_u64(header + TABLEBASE_KEY_OFFSET) !=
+	    board_key(game)) {
+	close_file(&game->tablebase);
+	game->tablebase.contents = 0;
 	return;
     }
+    // Each move looks up a single slot, anywhere in the file
+    if (game->tablebase.mapped) {
+	posix_madvise(game->tablebase.contents, size, POSIX_MADV_RANDOM);
+    }
+    game->tablebaseSlots = slots;
+}
 
-    // Process and validate human move (this includes saving)
-    human_move(move, game, rowMoveErrors, columnMoveErrors, eofFlag); 
+int tablebase_move(Game* game) {
+    if (!game->tablebaseSlots) {
+	return 0;
+    }
+    const unsigned char* slots = (const unsigned char*)
+	    game->tablebase.contents + TABLEBASE_HEADER_SIZE;
+    uint64_t i = game->key & (game->tablebaseSlots - 1);
+    for (uint64_t probes = 0; probes < game->tablebaseSlots; probes++) {
+	const unsigned char* slot = slots + i * TABLEBASE_SLOT_SIZE;
+	uint64_t key = read_binary_u64(slot);
+	if (!key) {
+	    return 0;
+	} else if (key == game->key) {
+	    uint32_t move =
+		    read_binary_u32(slot + TABLEBASE_SLOT_MOVE_OFFSET);
+	    game->rowMove = move / game->columns;
+	    game->columnMove = move % game->columns;
+	    return game->rowMove < game->rows &&
+		    move_legal(game, game->rowMove, game->columnMove);
+	}
+	i = (i + 1) & (game->tablebaseSlots - 1);
+    }
+    return 0;
 }
 
-void play_move(char* rowMoveErrors, char* columnMoveErrors, Game* game) {
-    /* Check strtol invalid inputs, out of bound human moves, and ensures
-     * chosen cell is empty */
-    if (*rowMoveErrors == '\0' && *columnMoveErrors == '\0' &&
-	    game->rowMove > 0 && game->rowMove < game->rows - 1 &&
-	    game->columnMove > 0 &&
-	    game->columnMove < game->columns - 1 &&
-	    game->board[game->rowMove][MOVE_INDEX] == '.') {	
-	game->board[game->rowMove][MOVE_INDEX] =
-		game->currentPlayer;
-	
-	// Check if current player is automated, display move
-	if ((game->currentPlayer == 'O' && game->playerTypeO != 'H') ||
-		(game->currentPlayer == 'X' &&
-		game->playerTypeX != 'H')) {
-	    printf("Player %c placed at %ld %ld\n", game->currentPlayer,
-		    game->rowMove, game->columnMove);
-	}
-	
-	// Print the board
-	for (int r = 0; r < game->rows; r++) {
-	    printf("%s\n", game->board[r]);
-	}
-
-	// Swap player for next move
-	game->currentPlayer = (game->currentPlayer == 'X') ? 'O' : 'X';
-    } else if (*rowMoveErrors == '\0' && *columnMoveErrors == '\0' &&
-	    ((game->rowMove == 0 || game->rowMove == game->rows - 1) !=
-	    (game->columnMove == 0 || game->columnMove ==
-	    game->columns - 1)) &&
-	    game->board[game->rowMove][MOVE_INDEX] == '.') {
-	/* Above condition with != acts as logical XOR. Ensures that if move
-	 * is in the border, it is not in a corner */
-	
-	/* Check if move is in border and cell is empty, handles pushing cell
-	 * moves */
-	push_move(game);
-    }
-}
-
-void type_zero_move(char** move, char** rowMoveErrors,
-	char** columnMoveErrors, Game* game) {
-    /* Handle player O type 0 moves; iterate through the board top to bottom,
-     * left to right, until an empty cell is found. */
-    if (game->currentPlayer == 'O' && game->playerTypeO == '0') {
-	for (int r = 1; r < game->rows - 1; r++) {
-	    for (int c = 3; c < SCORE_COLUMN_OF_LAST_CELL; c++) {
-		if (game->board[r][c] == '.') {
-		    /* Set *move to "automated" so that play_move does not
-		     * free the move variable (it otherwise free's the move
-		     * variable as it is malloc'd by read_line for human
-		     * moves) */
-		    *move = "automated";
-		    game->rowMove = r; 
-		    game->columnMove = COLUMN_MOVE;
-		    
-		    /* Set errors to == '\0' so that play_move can process the
-		     * move */
-		    *rowMoveErrors = *columnMoveErrors = "";
-		    return;
-		}
+int negamax(Game* game, int depth, int alpha, int beta, int ply,
+	long int* bestRow, long int* bestColumn) {
+    // Positions are valued as the score difference for the player to move
+    int value = (game->currentPlayer == 'O') ?
+	    game->scoreO - game->scoreX : game->scoreX - game->scoreO;
+    *bestRow = *bestColumn = -1;
+    game->searchNodes++;
+    if ((game->deadlineSet || game->stopFlag) && ply &&
+	    !(game->searchNodes & (SEARCH_CHECK_NODES - 1)) &&
+	    ((game->deadlineSet && deadline_passed(&game->deadline)) ||
+	    (game->stopFlag &&
+	    __atomic_load_n(game->stopFlag, __ATOMIC_RELAXED)))) {
+	game->searchStopped = 1;
+    }
+    if (game->searchStopped) {
+	return 0;
+    } else if (depth == 0 || check_board_full(game)) {
+	return value;
+    }
+
+    /* Reuse what is known of the position from the transposition table,
+     * trying the best move found for it first */
+    uint64_t key = game->key;
+    TableEntry entry;
+    long int firstRow = -1;
+    long int firstColumn = -1;
+    if (table_probe(game, key, &entry)) {
+	if (entry.depth >= depth) {
+	    if (entry.bound == BOUND_EXACT) {
+		*bestRow = entry.row;
+		*bestColumn = entry.column;
+		return entry.value;
+	    } else if (entry.bound == BOUND_LOWER && entry.value > alpha) {
+		alpha = entry.value;
+	    } else if (entry.bound == BOUND_UPPER && entry.value < beta) {
+		beta = entry.value;
 	    }
-	}
-    } else if(game->currentPlayer == 'X' && game->playerTypeX == '0') {
-	/* Handle player X type 0 moves; iterate through the board bottom to
-	 * top, right to left, until an empty cell is found. */
-	for (int r = game->rows - 2; r > 0; r--) {
-	    for (int c = LAST_INTERIOR_CELL_COLUMN; c > 2; c--) {
-		if (game->board[r][c] == '.') {
-		    // See the player O type 0 comments
-		    *move = "automated";
-		    game->rowMove = r;
-		    game->columnMove = COLUMN_MOVE;
-		    *rowMoveErrors = *columnMoveErrors = "";
-		    return;
-		}
+	    if (alpha >= beta) {
+		*bestRow = entry.row;
+		*bestColumn = entry.column;
+		return entry.value;
 	    }
 	}
+	firstRow = entry.row;
+	firstColumn = entry.column;
     }
+
+    /* Try every legal move (placements and pushes alike), the move from the
+     * table first and then the most promising moves (see order_moves) */
+    Move* moves = game->searchMoves + ply * MOVE_CAPACITY;
+    int moveCount = order_moves(game, moves, firstRow, firstColumn);
+    int originalAlpha = alpha;
+    int best = -SEARCH_INFINITY;
+    for (int i = 0; i < moveCount; i++) {
+	value = -search_move(game, &moves[i], depth - 1, -beta, -alpha, ply);
+	if (game->searchStopped) {
+	    return 0;
+	}
+	if (value > best) {
+	    best = value;
+	    *bestRow = moves[i].row;
+	    *bestColumn = moves[i].column;
+	}
+	if (best > alpha) {
+	    alpha = best;
+	}
+	if (alpha >= beta) {
+	    break;
+	}
+    }
+
+    entry.key = key;
+    entry.row = *bestRow;
+    entry.column = *bestColumn;
+    entry.value = best;
+    entry.depth = depth;
+    entry.bound = (best <= originalAlpha) ? BOUND_UPPER :
+	    (best >= beta) ? BOUND_LOWER : BOUND_EXACT;
+    table_store(game, &entry);
+    return best;
 }
 
-void type_one_move(Game* game, char opponent, char** move,
-	char** rowMoveErrors, char** columnMoveErrors) {
-    /* This conditional essentially checks each type one move in the order
-     * specified in the spec until a valid move is found. */
-    if (type_one_push_down(game, opponent, move, rowMoveErrors,
-	    columnMoveErrors)) {
-	return;
-    } else if (type_one_push_left(game, opponent, move,
-	    rowMoveErrors, columnMoveErrors)) {
-	return;
-    } else if (type_one_push_up(game, opponent, move,
-	    rowMoveErrors, columnMoveErrors)) {
+int table_probe(Game* game, uint64_t key, TableEntry* entry) {
+    if (!game->sharedTable) {
+	*entry = game->table[key & (TABLE_SIZE - 1)];
+	return entry->key == key;
+    }
+
+    /* Each word is read once, and the entry is only used if its check (the
+     * key XORed with the rest) matches */
+    uint64_t* words = game->sharedTable->words +
+	    (key & (TABLE_SIZE - 1)) * TABLE_WORDS;
+    uint64_t check = __atomic_load_n(&words[0], __ATOMIC_RELAXED);
+    uint64_t data = __atomic_load_n(&words[1], __ATOMIC_RELAXED);
+    uint64_t move = __atomic_load_n(&words[2], __ATOMIC_RELAXED);
+    if ((check ^ data ^ move) != key) {
+	return 0;
+    }
+    entry->key = key;
+    entry->value = (int32_t)(uint32_t)data;
+    entry->depth = (int16_t)(uint16_t)(data >> 32);
+    entry->bound = (int16_t)(data >> 48 & 0xff);
+    entry->row = (int32_t)(uint32_t)move;
+    entry->column = (int32_t)(uint32_t)(move >> 32);
+    return 1;
+}
+
+void table_store(Game* game, const TableEntry* entry) {
+    if (!game->sharedTable) {
+	game->table[entry->key & (TABLE_SIZE - 1)] = *entry;
 	return;
-    } else if (type_one_push_right(game, opponent, move,
-	    rowMoveErrors, columnMoveErrors)) {
+    }
+
+    /* Keep a deeper entry of another position stored during this move, as
+     * it saved more work. Entries of earlier moves (or torn ones) go first. */
+    uint64_t* words = game->sharedTable->words +
+	    (entry->key & (TABLE_SIZE - 1)) * TABLE_WORDS;
+    uint8_t age = game->sharedTable->age;
+    uint64_t check = __atomic_load_n(&words[0], __ATOMIC_RELAXED);
+    uint64_t data = __atomic_load_n(&words[1], __ATOMIC_RELAXED);
+    uint64_t move = __atomic_load_n(&words[2], __ATOMIC_RELAXED);
+    if ((check ^ data ^ move) != entry->key && (uint8_t)(data >> 56) == age &&
+	    (int16_t)(uint16_t)(data >> 32) > entry->depth) {
 	return;
-    } else {
-	type_one_highest_cell(game, move, rowMoveErrors,
-		columnMoveErrors);
     }
+    data = (uint32_t)entry->value | (uint64_t)(uint16_t)entry->depth << 32 |
+	    (uint64_t)(uint8_t)entry->bound << 48 | (uint64_t)age << 56;
+    move = (uint32_t)entry->row | (uint64_t)(uint32_t)entry->column << 32;
+    __atomic_store_n(&words[0], entry->key ^ data ^ move, __ATOMIC_RELAXED);
+    __atomic_store_n(&words[1], data, __ATOMIC_RELAXED);
+    __atomic_store_n(&words[2], move, __ATOMIC_RELAXED);
 }
 
-int type_one_push_down(Game* game, char opponent, char** move,
-	char** rowMoveErrors, char** columnMoveErrors) {
-    int scoreCol, scorePush, r, c;
-    for (c = 3; c < SCORE_COLUMN_OF_LAST_CELL; c += 2) {
-	scoreCol = 0;
-	scorePush = 0;
-	// Ensure pushing rules are met
-	if (game->board[0][c] != '.' ||
-		game->board[1][c] == '.' ||
-		game->board[game->rows - 1][c] != '.') {
-	    continue;
-	}
-	
-	/* Calculate score of both players that is contributed to by the cells
-	 * in a specific column, and check what these scores would be if a
-	 * pushing cells move was made */
-	for (r = 0; r < game->rows - 2; r++) {
-	    if (game->board[r + 1][c] == opponent) {
-		scoreCol += atoi(&game->board[r + 1][c - 1]);
-		scorePush += atoi(&game->board[r + 2][c - 1]); 
-	    } else if (game->board[r + 1][c] == '.') {
-		break;
-	    }
-	}
-	if (scorePush < scoreCol) {
-	    /* Set *move to "automated" so that play_move does not free the
-	     * move variable (it otherwise free's the move variable as it is
-	     * malloc'd by read_line for human moves) */
-	    *move = "automated";
+int search_move(Game* game, const Move* move, int depth, int alpha, int beta,
+	int ply) {
+    Undo undo;
+    make_move(game, move, &undo);
+    long int row, column;
+    int value = negamax(game, depth, alpha, beta, ply + 1, &row, &column);
+    unmake_move(game, &undo);
+    return value;
+}
 
-	    game->rowMove = 0;
-	    game->columnMove = COLUMN_MOVE;
-		    
-	    // Set errors to == '\0' so that play_move can process the move
-	    *rowMoveErrors = *columnMoveErrors = "";
-	    return 1;
+int order_moves(Game* game, Move* moves, long int firstRow,
+	long int firstColumn) {
+    int moveCount = generate_moves(game, moves);
+    for (int n = 0; n < moveCount; n++) {
+	/* Placements are ordered by the score they gain, pushes (which move
+	 * many stones at once) come before all but the best cells */
+	Move move = moves[n];
+	move.order = (move.row == firstRow && move.column == firstColumn) ?
+		INT16_MAX : (move.push != PUSH_NONE) ? PUSH_ORDER :
+		SCORE_AT(move.row, move.column);
+
+	// Insertion sort, the moves are mostly few and nearly in order
+	int i = n;
+	for (; i > 0 && moves[i - 1].order < move.order; i--) {
+	    moves[i] = moves[i - 1];
 	}
+	moves[i] = move;
     }
-    return 0;
+    return moveCount;
 }
 
-int type_one_push_left(Game* game, char opponent, char** move,
-	char** rowMoveErrors, char** columnMoveErrors) {
-    int scoreCol, scorePush, r, c;
-    for (r = 1; r < game->rows - 1; r++) {
-	scoreCol = 0;
-	scorePush = 0;
-	// Ensure pushing rules are met
-	if (game->board[r][LAST_CELL_COLUMN] != '.' ||
-		game->board[r][LAST_INTERIOR_CELL_COLUMN] == '.' ||
-		game->board[r][1] != '.') {
-	    continue;
+void type_three_move(char** rowMoveErrors, char** columnMoveErrors,
+	Game* game) {
+    int threads = (game->options.threads > 1) ? game->options.threads : 1;
+    if (!game->searchers) {
+	game->searchers = (Searcher*)calloc(threads, sizeof(Searcher));
+	game->searcherCount = game->searchers ? threads : 0;
+    }
+    Searcher* searchers = game->searchers;
+
+    /* The iterations are shared out between the threads. A move time (if
+     * given) is the only budget, unless iterations are also given. */
+    long int iterations = game->options.iterations ? game->options.iterations :
+	    game->options.moveTimeMs ? LONG_MAX : MCTS_ITERATIONS;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int ready = 0;
+    for (; ready < game->searcherCount; ready++) {
+	if (!start_searcher(game, &searchers[ready], ready)) {
+	    break;
 	}
+    }
 
-	/* Calculate score of both players that is contributed to by the cells
-	 * in a specific row, and check what these scores would be if a
-	 * pushing cells move was made */
-	for (c = LAST_CELL_COLUMN; c > 4; c -= 2) {
-	    if (game->board[r][c - 2] == opponent) {
-		scoreCol += atoi(&game->board[r][c - 3]);
-		scorePush += atoi(&game->board[r][c - 5]);
-	    } else if (game->board[r][c - 2] == '.') {
-		break;
-	    }
-	}	
-	if (scorePush < scoreCol) {
-	    /* Set *move to "automated" so that play_move does not free the
-	     * move variable (it otherwise free's the move variable as it is
-	     * malloc'd by read_line for human moves) */
-	    *move = "automated";
+    /* Only the searchers that could be started search, and if none could
+     * be, the move is the one a type 1 player would make */
+    if (!ready) {
+	type_one_move(game, (game->currentPlayer == 'X') ? 'O' : 'X',
+		rowMoveErrors, columnMoveErrors);
+	return;
+    }
+    threads = ready;
+    for (int t = 0; t < threads; t++) {
+	searchers[t].iterations = iterations / threads +
+		(t < iterations % threads);
+    }
 
-	    game->rowMove = r;
-	    game->columnMove = game->columns - 1;
-	    
-	    // Set errors to == '\0' so that play_move can process the move 
-	    *rowMoveErrors = *columnMoveErrors = "";
-	    return 1;
+    // The first searcher is the main thread itself
+    pthread_t* ids = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    for (int t = 1; t < threads; t++) {
+	pthread_create(&ids[t], 0, mcts_search, &searchers[t]);
+    }
+    mcts_search(&searchers[0]);
+    for (int t = 1; t < threads; t++) {
+	pthread_join(ids[t], 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(ids);
+
+    // Take the move played through the most over every tree
+    Node* root = &searchers[0].nodes[0];
+    long int bestVisits = -1;
+    for (int32_t i = 0; i < root->childCount; i++) {
+	long int visits = 0;
+	for (int t = 0; t < threads; t++) {
+	    visits += searchers[t].nodes[root->firstChild + i].visits;
+	}
+	if (visits > bestVisits) {
+	    bestVisits = visits;
+	    game->rowMove = searchers[0].nodes[root->firstChild + i].row;
+	    game->columnMove =
+		    searchers[0].nodes[root->firstChild + i].column;
 	}
     }
-    return 0;
+    for (int t = 0; t < threads; t++) {
+	game->stats.searchIterations += searchers[t].nodes[0].visits;
+    }
+    game->stats.searchSeconds += (end.tv_sec - start.tv_sec) +
+	    (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    // Set errors to == '\0' so that play_move can process the move
+    *rowMoveErrors = *columnMoveErrors = "";
 }
 
-int type_one_push_up(Game* game, char opponent, char** move,
-	char** rowMoveErrors, char** columnMoveErrors) {
-    int scoreCol, scorePush, r, c;
-    for (c = LAST_INTERIOR_CELL_COLUMN; c > 2; c -= 2) {
-	scoreCol = 0;
-	scorePush = 0;
-	// Ensure pushing rules are met
-	if (game->board[game->rows - 1][c] != '.' ||
-		game->board[game->rows - 2][c] == '.' ||
-		game->board[0][c] != '.') {
-	    continue;
-	}
-	
-	/* Calculate score of both players that is contributed to by the cells
-	 * in a specific column, and check what these scores would be if a
-	 * pushing cells move was made */
-	for (r = game->rows - 1; r > 1; r--) {
-	    if (game->board[r - 1][c] == opponent) {
-		scoreCol += atoi(&game->board[r - 1][c - 1]);
-		scorePush += atoi(&game->board[r - 2][c - 1]);
-	    } else if (game->board[r - 1][c] == '.') {
-		break;
+int start_searcher(Game* game, Searcher* searcher, int t) {
+    // Each searcher's copy of the game is made on the player's first move
+    if (!searcher->game) {
+	searcher->game = copy_game(game);
+	searcher->rootState = (char*)malloc(game->stateSize);
+	searcher->nodeCapacity = 1024;
+	searcher->nodes =
+		(Node*)malloc(searcher->nodeCapacity * sizeof(Node));
+	if (!searcher->game || !searcher->rootState || !searcher->nodes) {
+	    if (searcher->game) {
+		game_free_memory(searcher->game);
 	    }
+	    free(searcher->rootState);
+	    free(searcher->nodes);
+	    memset(searcher, 0, sizeof(Searcher));
+	    return 0;
+	}
+	searcher->game->playerTypeO = searcher->game->playerTypeX =
+		(game->options.playout == PLAYOUT_ONE) ? '1' : '0';
+    }
+    memcpy(searcher->rootState, game->stonesO, game->stateSize);
+    searcher->rootScoreO = game->scoreO;
+    searcher->rootScoreX = game->scoreX;
+    searcher->rootEmptyCells = game->emptyCells;
+    searcher->rootPlayer = game->currentPlayer;
+    searcher->rootKey = game->key;
+    searcher->random = zobrist_mix(game->key + t);
+    if (game->options.moveTimeMs) {
+	searcher->deadlineSet = 1;
+	set_deadline(&searcher->deadline, game->options.moveTimeMs);
+    }
+
+    /* Every tree starts with the root expanded, so their roots match
+     * (the copy still being where the last search left it) */
+    restore_root(searcher);
+    searcher->nodes[0] = (Node){-1, -1, -1, -1, -1, 0, 0, 0};
+    searcher->nodeCount = 1;
+    return mcts_expand(searcher, 0);
+}
+
+void* mcts_search(void* argument) {
+    Searcher* searcher = (Searcher*)argument;
+    Game* game = searcher->game;
+    for (long int i = 0; i < searcher->iterations; i++) {
+	if (searcher->deadlineSet && deadline_passed(&searcher->deadline)) {
+	    break;
 	}
 
-	if (scorePush < scoreCol) {
-	    /* Set *move to "automated" so that play_move does not free the
-	     * move variable (it otherwise free's the move variable as it is
-	     * malloc'd by read_line for human moves) */
-	    *move = "automated";
-	    game->rowMove = game->rows - 1;
-	    game->columnMove = COLUMN_MOVE;
+	// Start from the position being searched
+	restore_root(searcher);
+
+	/* Select a path down the tree, expanding the node at the end of it
+	 * (unless the game is over there) and stepping into its first child */
+	int32_t index = 0;
+	while (searcher->nodes[index].childCount > 0) {
+	    index = mcts_select(searcher, index);
+	    game->rowMove = searcher->nodes[index].row;
+	    game->columnMove = searcher->nodes[index].column;
+	    play_move("", "", game);
+	}
+	if (searcher->nodes[index].childCount < 0 &&
+		!check_board_full(game) && mcts_expand(searcher, index)) {
+	    index = searcher->nodes[index].firstChild;
+	    game->rowMove = searcher->nodes[index].row;
+	    game->columnMove = searcher->nodes[index].column;
+	    play_move("", "", game);
+	}
 
-	    // Set errors to == '\0' so that play_move can process the move
-	    *rowMoveErrors = *columnMoveErrors = "";
-	    return 1;
+	// Play the rest of the game out, and add its result to the path
+	while (!check_board_full(game)) {
+	    playout_move(searcher);
+	}
+	float resultO = (game->scoreO > game->scoreX) ? 1 :
+		(game->scoreO < game->scoreX) ? 0 : 0.5;
+	for (; index >= 0; index = searcher->nodes[index].parent) {
+	    Node* node = &searcher->nodes[index];
+	    node->visits++;
+	    node->wins += (node->player == 'O') ? resultO : 1 - resultO;
 	}
     }
     return 0;
 }
 
-int type_one_push_right(Game* game, char opponent, char** move,
-	char** rowMoveErrors, char** columnMoveErrors) {
-    int scoreCol, scorePush, r, c;
-    for (r = game->rows - 2; r > 0; r--) {
-	scoreCol = 0;
-	scorePush = 0;
-	// Ensure pushing rules are met
-	if (game->board[r][1] != '.' ||
-		game->board[r][3] == '.' ||
-		game->board[r][LAST_CELL_COLUMN] != '.') {
-	    continue;
-	}
+void restore_root(Searcher* searcher) {
+    Game* game = searcher->game;
+    memcpy(game->stonesO, searcher->rootState, game->stateSize);
+    game->scoreO = searcher->rootScoreO;
+    game->scoreX = searcher->rootScoreX;
+    game->emptyCells = searcher->rootEmptyCells;
+    game->currentPlayer = searcher->rootPlayer;
+    game->key = searcher->rootKey;
+}
 
-	/* Calculate score of both players that is contributed to by the cells
-	 * in a specific column, and check what these scores would be if a
-	 * pushing cells move was made */
-	for (c = 1; c < SCORE_COLUMN_OF_LAST_INTERIOR_CELL; c += 2) {
-	    if (game->board[r][c + 2] == opponent) {
-		scoreCol += atoi(&game->board[r][c + 1]);
-		scorePush += atoi(&game->board[r][c + 3]);
-	    } else if (game->board[r][c + 2] == '.') {
-		break;
-	    }
+int32_t mcts_select(Searcher* searcher, int32_t index) {
+    Node* node = &searcher->nodes[index];
+    double logVisits = log(node->visits);
+    int32_t best = node->firstChild;
+    double bestBound = -1;
+    for (int32_t i = node->firstChild;
+	    i < node->firstChild + node->childCount; i++) {
+	Node* child = &searcher->nodes[i];
+	if (!child->visits) {
+	    return i;
+	}
+	double bound = child->wins / child->visits +
+		MCTS_EXPLORATION * sqrt(logVisits / child->visits);
+	if (bound > bestBound) {
+	    bestBound = bound;
+	    best = i;
 	}
+    }
+    return best;
+}
 
-	if (scorePush < scoreCol) {
-	    /* Set *move to "automated" so that play_move does not free the
-	     * move variable (it otherwise free's the move variable as it is
-	     * malloc'd by read_line for human moves) */
-	    *move = "automated";
-	    game->rowMove = r;
-	    game->columnMove = 0;
-	    
-	    // Set errors to == '\0' so that play_move can process the move
-	    *rowMoveErrors = *columnMoveErrors = "";
-	    return 1;
+int mcts_expand(Searcher* searcher, int32_t index) {
+    Game* game = searcher->game;
+    int moveCount = order_moves(game, game->moves, -1, -1);
+    while (searcher->nodeCount + moveCount > searcher->nodeCapacity) {
+	Node* nodes = (Node*)realloc(searcher->nodes,
+		2 * searcher->nodeCapacity * sizeof(Node));
+	if (!nodes) {
+	    return 0;
 	}
+	searcher->nodes = nodes;
+	searcher->nodeCapacity *= 2;
     }
-    return 0;
+    searcher->nodes[index].firstChild = searcher->nodeCount;
+    searcher->nodes[index].childCount = moveCount;
+    for (int i = 0; i < moveCount; i++) {
+	searcher->nodes[searcher->nodeCount++] = (Node){
+		game->moves[i].row, game->moves[i].column, index, -1,
+		-1, 0, 0, game->currentPlayer};
+    }
+    return 1;
+}
+
+void playout_move(Searcher* searcher) {
+    Game* game = searcher->game;
+    char* rowMoveErrors;
+    char* columnMoveErrors;
+    if (!(next_random(&searcher->random) % MCTS_RANDOM_MOVES)) {
+	empty_cell_move(game, next_random(&searcher->random) %
+		game->emptyCells, &rowMoveErrors, &columnMoveErrors);
+    } else if (game->playerTypeO == '1') {
+	type_one_move(game, (game->currentPlayer == 'X') ? 'O' : 'X',
+		&rowMoveErrors, &columnMoveErrors);
+    } else {
+	type_zero_move(&rowMoveErrors, &columnMoveErrors, game);
+    }
+    play_move(rowMoveErrors, columnMoveErrors, game);
+}
+
+uint64_t next_random(uint64_t* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
 }
 
-void type_one_highest_cell(Game* game, char** move, char** rowMoveErrors,
+void empty_cell_move(Game* game, long int index, char** rowMoveErrors,
 	char** columnMoveErrors) {
-    int currentScoreO, currentScoreX, maxRow, maxColumn;
-    current_score_calc(&currentScoreO, &currentScoreX, game); 
-    
-    int maxScore = 0;
-    if (game->board[1][3] == '.') {
-        maxScore = atoi(&game->board[1][2]); // Set to first cell if empty
-    }
-    // Iterate through board interior and find highest valued cell
-    for (int r = 1; r < game->rows - 1; r++) {
-        for (int c = 2; c < SCORE_COLUMN_OF_LAST_CELL; c += 2) {
-	    if (game->board[r][c + 1] == '.' && maxScore <
-		    atoi(&game->board[r][c])) {
-		maxRow = r;
-		maxColumn = c;
-		maxScore = atoi(&game->board[maxRow][maxColumn]);
-		if (currentScoreO == currentScoreX) {
-		    /* Set *move to sentinel value so that play_move can
-		     * handle invalid free (human move needs malloc) */
-		    *move = "automated";
-		    game->rowMove = maxRow;
-		    /* Each cell contains 2 chars, the score and the player */
-		    game->columnMove = maxColumn / 2;
-		    /* Set errors to '/0' so that play_move processes *move */
-		    *rowMoveErrors = *columnMoveErrors = "";
-		    return;
-		}
-	    }
-	}
+    // Find the row of the cell, then the cell within the row
+    long int r = 1;
+    for (; index >= game->rowEmpties[r]; r++) {
+	index -= game->rowEmpties[r];
     }
-    // For case when tied but all cells of equal value
-    if (currentScoreO == currentScoreX) {
-        for (int r = 1; r < game->rows - 1; r++) {
-	    for (int c = 2; c < SCORE_COLUMN_OF_LAST_CELL; c += 2) {
-		if (game->board[r][c + 1] == '.') {
-		    *move = "automated";
-		    game->rowMove = r;
-		    game->columnMove = c / 2;
-		    *rowMoveErrors = *columnMoveErrors = "";
-		    return;
-		}
+    for (long int w = 0;; w++) {
+	BoardWord empty = game->interiorMask[w] &
+		~(ROW_WORDS_OF(game->stonesO, r)[w] |
+		ROW_WORDS_OF(game->stonesX, r)[w]);
+	long int count = __builtin_popcountll(empty);
+	if (index < count) {
+	    for (; index > 0; index--) {
+		empty &= empty - 1;
 	    }
+	    game->rowMove = r;
+	    game->columnMove = w * WORD_BITS + __builtin_ctzll(empty);
+	    break;
 	}
+	index -= count;
     }
-    // This last block handles normal situation without ties
-    *move = "automated";
-    game->rowMove = maxRow;
-    game->columnMove = maxColumn / 2;
     *rowMoveErrors = *columnMoveErrors = "";
-    return;
 }
 
-void human_move(char** move, Game* game, char** rowMoveErrors,
+Game* copy_game(Game* game) {
+    Game* copy = (Game*)malloc(sizeof(Game));
+    if (!copy) {
+	return 0;
+    }
+    *copy = *game;
+
+    /* The copy shares none of the game's buffers, displays nothing, and
+     * counts its searches from scratch */
+    memset(&copy->stats, 0, sizeof(Stats));
+    copy->journal = 0;
+    copy->table = 0;
+    copy->sharedTable = 0;
+    copy->stopFlag = 0;
+    copy->searchMoves = 0;
+    copy->searchPlies = 0;
+    copy->searchers = 0;
+    copy->searcherCount = 0;
+    copy->helperPool = 0;
+    copy->tablebase.contents = 0;
+    copy->tablebaseSlots = 0;
+    memset(&copy->input, 0, sizeof(InputBuffer));
+    copy->verbosity = VERBOSITY_NONE;
+    if (!alloc_arena(copy)) {
+	free(copy);
+	return 0;
+    }
+    memcpy(copy->stonesO, game->stonesO, game->arenaSize);
+    return copy;
+}
+
+void report_search(const char* name, long int iterations, double seconds) {
+    if (iterations) {
+	fprintf(stderr, "%s: %ld iterations in %.3f s (%.0f iterations/s)\n",
+		name, iterations, seconds, seconds > 0 ? iterations / seconds :
+		0.0);
+    }
+}
+
+void add_stats(Stats* total, const Stats* stats) {
+    total->searchIterations += stats->searchIterations;
+    total->searchSeconds += stats->searchSeconds;
+    total->timedMoves += stats->timedMoves;
+    total->timedDepths += stats->timedDepths;
+    total->timedNodes += stats->timedNodes;
+    total->timedSeconds += stats->timedSeconds;
+    if (stats->timedSlowest > total->timedSlowest) {
+	total->timedSlowest = stats->timedSlowest;
+    }
+    total->solveMoves += stats->solveMoves;
+    total->solveNodes += stats->solveNodes;
+    total->solveSeconds += stats->solveSeconds;
+    if (stats->solveSlowest > total->solveSlowest) {
+	total->solveSlowest = stats->solveSlowest;
+    }
+}
+
+void report_timed(const char* name, long int moves, long int depths,
+	long int nodes, double seconds, double slowest) {
+    if (moves) {
+	fprintf(stderr, "%s: searched %ld moves to a mean depth of %.1f, %ld "
+		"nodes in %.3f s (%.0f nodes/s), slowest move %.3f s\n", name,
+		moves, (double)depths / moves, nodes, seconds,
+		seconds > 0 ? nodes / seconds : 0.0, slowest);
+    }
+}
+
+void set_deadline(struct timespec* deadline, long int milliseconds) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += milliseconds / 1000;
+    deadline->tv_nsec += milliseconds % 1000 * 1000000;
+    if (deadline->tv_nsec >= 1000000000) {
+	deadline->tv_sec++;
+	deadline->tv_nsec -= 1000000000;
+    }
+}
+
+int deadline_passed(const struct timespec* deadline) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec &&
+	    now.tv_nsec >= deadline->tv_nsec);
+}
+
+void report_solve(const char* name, long int moves, long int nodes,
+	double seconds, double slowest) {
+    if (moves) {
+	fprintf(stderr, "%s: solved %ld moves, %ld nodes in %.3f s (%.0f "
+		"nodes/s), slowest move %.3f s\n", name, moves, nodes,
+		seconds, seconds > 0 ? nodes / seconds : 0.0, slowest);
+    }
+}
+
+void human_move(char* move, Game* game, char** rowMoveErrors,
 	char** columnMoveErrors, int* eofFlag) {
-    // Ensure exactly one space is in move
-    int spaceCounter = space_counter(move);
-
-    // Check for blank moves, invalid chars, leading and trailing spaces/tabs
-    char* endOfMove = *move + strlen(*move) - 1;
-    if (endOfMove < *move || (**move != 's' &&
-	    (**move == ' ' || !isdigit(*endOfMove)
-	    || **move == '\t' ||
-	    spaceCounter != 1))) {
-	// Sentinel values to ensure move is considered invalid
-	game->rowMove = -1;
-	game->columnMove = -1;
-	
-	/* Set errors to == '\0' so that play_move can process and handle the
-	 * invalid move */
-	*rowMoveErrors = *columnMoveErrors = "";
-	if (!strcmp(*move, "automated")) {
-	    *rowMoveErrors = "automatedHuman";
-	}
+    *rowMoveErrors = *columnMoveErrors = "";
 
-	/* Ensure appropriate formatting if a valid move that was previously
-	 * processed ended in EOF */
-	if (*eofFlag) {
-	    printf("\n");
-	}
+    // Saving - any move starting with an s, the rest is the save file name
+    if (*move == 's') {
+	save_game(move + 1, game);
 	return;
     }
 
-    // Saving - if not saving process row and column moves
-    if (**move != 's') {
-	game->rowMove = strtol(strtok(*move, " "), rowMoveErrors, 10);
-	game->columnMove = strtol(strtok(NULL, " "), columnMoveErrors, 10);
-	if (*eofFlag) {
-	    printf("\n");
-	}
-    } else {
-	save_game(rowMoveErrors, columnMoveErrors, move, game);
+    /* Full frames can be asked for in delta mode, which (as with a save)
+     * leaves the move to be made still */
+    if (game->verbosity == VERBOSITY_DELTA && !strcmp(move, "f")) {
+	print_frame(game, 0);
+	game->rowMove = game->columnMove = 0;
+	return;
+    }
+
+    /* Process the row and column moves, in the same pass as they are
+     * validated. Sentinel values ensure an invalid move is considered
+     * invalid by play_move. */
+    if (!parse_move(move, &game->rowMove, &game->columnMove)) {
+	game->rowMove = -1;
+	game->columnMove = -1;
+    }
+
+    /* Ensure appropriate formatting if a valid move that was previously
+     * processed ended in EOF */
+    if (*eofFlag) {
+	printf("\n");
     }
 }
 
 void current_score_calc(int* scoreO, int* scoreX, Game* game) {
     *scoreO = 0;
     *scoreX = 0;
-    for (int r = 0; r < game->rows; r++) {
-	/* As each char is represented as its own element in the internal game
-	 * representation, each column has both a score cell and a playing
-	 * cell, we must double the number of columns to index the end of the
-	 * board */
-	for (int c = 0; c < game->columns * 2; c++) {
-	    if (game->board[r][c] == 'O') {
-		*scoreO += atoi(&game->board[r][c - 1]);
-	    } else if (game->board[r][c] == 'X') {
-		*scoreX += atoi(&game->board[r][c - 1]);
+    for (long int r = 0; r < game->rows; r++) {
+	*scoreO += game->options.kernels->sumScores(&SCORE_AT(r, 0),
+		ROW_WORDS_OF(game->stonesO, r), game->rowWords);
+	*scoreX += game->options.kernels->sumScores(&SCORE_AT(r, 0),
+		ROW_WORDS_OF(game->stonesX, r), game->rowWords);
+    }
+}
+
+#ifdef DEBUG
+void verify_state(Game* game) {
+    int scoreO, scoreX;
+    current_score_calc(&scoreO, &scoreX, game);
+    if (scoreO != game->scoreO || scoreX != game->scoreX) {
+	fprintf(stderr, "Running scores %d %d differ from board %d %d\n",
+		game->scoreO, game->scoreX, scoreO, scoreX);
+	abort();
+    }
+
+    /* Count the empty cells, and check the other layout and the line
+     * counters of every cell */
+    long int emptyCells = 0;
+    for (long int r = 0; r < game->rows; r++) {
+	long int rowStones = 0;
+	for (long int c = 0; c < game->columns; c++) {
+	    char stone = cell_at(game, r, c);
+	    int columnO = (COLUMN_WORDS_OF(game->stonesByColumnO,
+		    c)[r / WORD_BITS] & CELL_BIT(r)) != 0;
+	    int columnX = (COLUMN_WORDS_OF(game->stonesByColumnX,
+		    c)[r / WORD_BITS] & CELL_BIT(r)) != 0;
+	    if (columnO != (stone == 'O') || columnX != (stone == 'X')) {
+		fprintf(stderr, "Column layout differs at %ld %ld\n", r, c);
+		abort();
 	    }
+	    rowStones += stone != '.';
+	    emptyCells += stone == '.' && r > 0 && r < game->rows - 1 &&
+		    c > 0 && c < game->columns - 1;
+	}
+	if (rowStones != game->rowStones[r]) {
+	    fprintf(stderr, "Row %ld stone count differs\n", r);
+	    abort();
+	}
+    }
+    for (long int c = 0; c < game->columns; c++) {
+	long int columnStones = 0;
+	for (long int r = 0; r < game->rows; r++) {
+	    columnStones += cell_at(game, r, c) != '.';
 	}
+	if (columnStones != game->columnStones[c]) {
+	    fprintf(stderr, "Column %ld stone count differs\n", c);
+	    abort();
+	}
+    }
+    if (emptyCells != game->emptyCells) {
+	fprintf(stderr, "Empty cell index %ld differs from board %ld\n",
+		game->emptyCells, emptyCells);
+	abort();
+    }
+    if (zobrist_hash(game) != game->key) {
+	fprintf(stderr, "Key %016" PRIx64 " differs from board %016" PRIx64
+		"\n", game->key, zobrist_hash(game));
+	abort();
     }
 }
+#endif
 
-void push_move(Game* game) {
-    int emptyCellCounter = 0;
-    int r, c;
-    r = c = 0;
-
-    /* Check if move is in edge and there is a stone immediately next to said
-     * edge cell to be pushed. Below checks if move is in bottom edge, top
-     * edge, right edge, and then left edge. */
-    if (game->rowMove == game->rows - 1 &&
-	    game->board[game->rows - 2][MOVE_INDEX] != '.') {
-	push_up(game, emptyCellCounter, r);
-    } else if (game->rowMove == 0 &&
-	    game->board[1][MOVE_INDEX] != '.') {
-	push_down(game, emptyCellCounter, r);
-    } else if (game->columnMove == game->columns - 1 &&
-	    game->board[game->rowMove][LAST_INTERIOR_CELL_COLUMN] != '.') {
-	push_left(game, emptyCellCounter, c);
-    } else if (game->columnMove == 0 &&
-	    game->board[game->rowMove][2 * (game->columnMove + 1) + 1] !=
-	    '.') {
-	push_right(game, emptyCellCounter, c);
-    }
-}
-
-void push_up(Game* game, int emptyCellCounter, int r) {
-    // Ensure column isn't full
-    for (r = game->rows - 3; r >= 0; r--) {
-        if (game->board[r][MOVE_INDEX] == '.') {
-	    emptyCellCounter++;
+void push_move(Game* game, Undo* undo) {
+    switch (undo->move.push) {
+	case PUSH_UP:
+	    push_up(game, undo);
+	    break;
+	case PUSH_DOWN:
+	    push_down(game, undo);
+	    break;
+	case PUSH_LEFT:
+	    push_left(game, undo);
+	    break;
+	default:
+	    push_right(game, undo);
 	    break;
-	}
     }
+}
 
-    /* If column isn't full, go to first empty cell and set it equal to the
-     * value of the cell below it, effectively pushing all cells in column
-     * upwards */
-    if (emptyCellCounter) {
-        for (int row = r; row < game->rows - 2; row++) {
-	    game->board[row][MOVE_INDEX] =
-		    game->board[row + 1][MOVE_INDEX];
-	}
-	
-	// Last cell must have value of player who made pushing cell move
-	game->board[game->rows - 2][MOVE_INDEX] =
-		game->currentPlayer;
+void push_up(Game* game, Undo* undo) {
+    /* Go to first empty cell above the pushed stone, and push all cells
+     * from there upwards */
+    long int c = undo->move.column;
+    undo->low = find_empty(COLUMN_WORDS_OF(game->stonesByColumnO, c),
+	    COLUMN_WORDS_OF(game->stonesByColumnX, c), game->rows - 3, -1);
+    undo->high = game->rows - 2;
+    push_line(game, 1, c, undo->low, undo->high, -1, game->currentPlayer);
+}
 
-	// If automated player (i.e. type 1) pushed cell, display move
-	if ((game->currentPlayer == 'O' && game->playerTypeO != 'H') ||
-		(game->currentPlayer == 'X' && game->playerTypeX != 'H')) {
-	    printf("Player %c placed at %ld %ld\n", game->currentPlayer,
-		    game->rowMove, game->columnMove);
-	}
+void push_down(Game* game, Undo* undo) {
+    /* Go to first empty cell below the pushed stone, and push all cells
+     * from there downwards */
+    long int c = undo->move.column;
+    undo->low = 1;
+    undo->high = find_empty(COLUMN_WORDS_OF(game->stonesByColumnO, c),
+	    COLUMN_WORDS_OF(game->stonesByColumnX, c), 2, 1);
+    push_line(game, 1, c, undo->low, undo->high, 1, game->currentPlayer);
+}
 
-	// Print board
-	for (r = 0; r < game->rows; r++) {
-	    printf("%s\n", game->board[r]);
-	}
+void push_left(Game* game, Undo* undo) {
+    /* Go to first empty cell left of the pushed stone, and push all cells
+     * from there to the left */
+    long int r = undo->move.row;
+    undo->low = find_empty(ROW_WORDS_OF(game->stonesO, r),
+	    ROW_WORDS_OF(game->stonesX, r), game->columns - 3, -1);
+    undo->high = game->columns - 2;
+    push_line(game, 0, r, undo->low, undo->high, -1, game->currentPlayer);
+}
 
-	// Swap current player for next move
-	game->currentPlayer = (game->currentPlayer == 'X') ? 'O' : 'X';
-    }
+void push_right(Game* game, Undo* undo) {
+    /* Go to first empty cell right of the pushed stone, and push all cells
+     * from there to the right */
+    long int r = undo->move.row;
+    undo->low = 1;
+    undo->high = find_empty(ROW_WORDS_OF(game->stonesO, r),
+	    ROW_WORDS_OF(game->stonesX, r), 2, 1);
+    push_line(game, 0, r, undo->low, undo->high, 1, game->currentPlayer);
 }
 
-void push_down(Game* game, int emptyCellCounter, int r) {
-    // Ensure column isn't full
-    for (r = 2; r < game->rows; r++) {
-        if (game->board[r][MOVE_INDEX] == '.') {
-	    emptyCellCounter++;
-	    break;
-	}
+long int find_empty(BoardWord* lineO, BoardWord* lineX, long int from,
+	int step) {
+    long int w = from / WORD_BITS;
+
+    /* Only consider the bits of the first word from the starting cell
+     * onwards (in the direction of the search) */
+    BoardWord empty = ~(lineO[w] | lineX[w]) & (step > 0 ?
+	    ~(CELL_BIT(from) - 1) : (CELL_BIT(from) - 1) | CELL_BIT(from));
+    while (!empty) {
+	w += step;
+	empty = ~(lineO[w] | lineX[w]);
     }
+    return w * WORD_BITS + (step > 0 ? __builtin_ctzll(empty) :
+	    WORD_BITS - 1 - __builtin_clzll(empty));
+}
 
-    /* If column isn't full, go to first empty cell and set it equal to the
-     * value of the cell above it, effectively pushing all cells in column
-     * downwards */
-    if (emptyCellCounter) {
-        for (int row = r; row > 1; row--) {
-	    game->board[row][MOVE_INDEX] =
-		    game->board[row - 1][MOVE_INDEX];
+void push_line(Game* game, int isColumn, long int line, long int low,
+	long int high, int step, char stone) {
+    BoardWord* lineO = isColumn ? COLUMN_WORDS_OF(game->stonesByColumnO,
+	    line) : ROW_WORDS_OF(game->stonesO, line);
+    BoardWord* lineX = isColumn ? COLUMN_WORDS_OF(game->stonesByColumnX,
+	    line) : ROW_WORDS_OF(game->stonesX, line);
+    long int lineWords = isColumn ? game->columnWords : game->rowWords;
+    long int pushed = step > 0 ? low : high;
+    long int filled = step > 0 ? high : low;
+    BoardWord playerBit = CELL_BIT(pushed);
+
+    /* Shift each word of the line that overlaps low to high by one cell.
+     * Words are shifted in the opposite order to the push so that the
+     * neighbouring word each shift borrows a bit from is not yet shifted. */
+    long int first = (step > 0 ? high : low) / WORD_BITS;
+    long int last = (step > 0 ? low : high) / WORD_BITS;
+    for (long int w = first; w != last - step; w -= step) {
+	BoardWord oldO = lineO[w];
+	BoardWord oldX = lineX[w];
+	BoardWord shiftedO, shiftedX;
+	if (step > 0) {
+	    shiftedO = (oldO << 1) | (w > 0 ? lineO[w - 1] >> 63 : 0);
+	    shiftedX = (oldX << 1) | (w > 0 ? lineX[w - 1] >> 63 : 0);
+	} else {
+	    shiftedO = (oldO >> 1) |
+		    (w + 1 < lineWords ? lineO[w + 1] << 63 : 0);
+	    shiftedX = (oldX >> 1) |
+		    (w + 1 < lineWords ? lineX[w + 1] << 63 : 0);
 	}
-	
-	// Last cell must have value of player who made pushing cell move
-	game->board[1][MOVE_INDEX] = game->currentPlayer;
 
-	// If automated player (i.e. type 1) pushed cell, display move
-	if ((game->currentPlayer == 'O' && game->playerTypeO != 'H') ||
-		(game->currentPlayer == 'X' && game->playerTypeX != 'H')) {
-	    printf("Player %c placed at %ld %ld\n", game->currentPlayer,
-		    game->rowMove, game->columnMove);
+	// Only the cells from low to high are moved
+	BoardWord mask = ~(BoardWord)0;
+	if (w == low / WORD_BITS) {
+	    mask &= ~(CELL_BIT(low) - 1);
 	}
-
-	// Print board
-	for (r = 0; r < game->rows; r++) {
-	    printf("%s\n", game->board[r]);
+	if (w == high / WORD_BITS) {
+	    mask &= (CELL_BIT(high) - 1) | CELL_BIT(high);
+	}
+	lineO[w] = (oldO & ~mask) | (shiftedO & mask);
+	lineX[w] = (oldX & ~mask) | (shiftedX & mask);
+
+	/* The pushed cell must have the stone given (that of the player who
+	 * made the push, or none when undoing the push) */
+	if (w == pushed / WORD_BITS) {
+	    lineO[w] = (lineO[w] & ~playerBit) | (stone == 'O' ? playerBit : 0);
+	    lineX[w] = (lineX[w] & ~playerBit) | (stone == 'X' ? playerBit : 0);
 	}
+	mirror_changes(game, isColumn, line, w, oldO ^ lineO[w],
+		oldX ^ lineX[w]);
+    }
 
-	// Swap current player for next move
-	game->currentPlayer = (game->currentPlayer == 'X') ? 'O' : 'X';
+    /* The only cell to change from empty to filled is the first empty cell,
+     * which increases the stone count of both lines through it. Undoing a
+     * push instead empties the pushed cell. */
+    long int cell = (stone == '.') ? pushed : filled;
+    int change = (stone == '.') ? -1 : 1;
+    long int r = isColumn ? cell : line;
+    long int c = isColumn ? line : cell;
+    game->rowStones[r] += change;
+    game->columnStones[c] += change;
+    if (r > 0 && r < game->rows - 1 && c > 0 && c < game->columns - 1) {
+	update_empty_index(game, r, -change);
     }
 }
 
-void push_left(Game* game, int emptyCellCounter, int c) {
-    // Ensure row isn't full
-    for (c = SECOND_LAST_INTERIOR_CELL_COLUMN; c >= 0; c--) {
-        if (game->board[game->rowMove][c] == '.') {
-	    emptyCellCounter++;
-	    break;
+void mirror_changes(Game* game, int isColumn, long int line, long int w,
+	BoardWord changedO, BoardWord changedX) {
+    BoardWord* lineO = isColumn ? COLUMN_WORDS_OF(game->stonesByColumnO,
+	    line) : ROW_WORDS_OF(game->stonesO, line);
+    BoardWord* lineX = isColumn ? COLUMN_WORDS_OF(game->stonesByColumnX,
+	    line) : ROW_WORDS_OF(game->stonesX, line);
+    BoardWord lineBit = CELL_BIT(line);
+
+    // Visit each cell that changed (taking and clearing the lowest bit)
+    for (BoardWord changed = changedO | changedX; changed;
+	    changed &= changed - 1) {
+	int bit = __builtin_ctzll(changed);
+	long int cell = w * WORD_BITS + bit;
+	long int r = isColumn ? cell : line;
+	long int c = isColumn ? line : cell;
+	BoardWord* crossO = isColumn ?
+		&ROW_WORDS_OF(game->stonesO, r)[c / WORD_BITS] :
+		&COLUMN_WORDS_OF(game->stonesByColumnO, c)[r / WORD_BITS];
+	BoardWord* crossX = isColumn ?
+		&ROW_WORDS_OF(game->stonesX, r)[c / WORD_BITS] :
+		&COLUMN_WORDS_OF(game->stonesByColumnX, c)[r / WORD_BITS];
+	BoardWord crossBit = isColumn ? CELL_BIT(c) : lineBit;
+
+	/* Update the running scores, the key, and the other layout of the
+	 * board */
+	if ((changedO >> bit) & 1) {
+	    game->key ^= ZOBRIST_AT(r, c, 'O');
+	    if ((lineO[w] >> bit) & 1) {
+		game->scoreO += SCORE_AT(r, c);
+		*crossO |= crossBit;
+	    } else {
+		game->scoreO -= SCORE_AT(r, c);
+		*crossO &= ~crossBit;
+	    }
+	}
+	if ((changedX >> bit) & 1) {
+	    game->key ^= ZOBRIST_AT(r, c, 'X');
+	    if ((lineX[w] >> bit) & 1) {
+		game->scoreX += SCORE_AT(r, c);
+		*crossX |= crossBit;
+	    } else {
+		game->scoreX -= SCORE_AT(r, c);
+		*crossX &= ~crossBit;
+	    }
 	}
     }
+}
 
-    /* If row isn't full, go to first empty cell and set it equal to the value
-     * of the cell right of it, effectively pushing all cells in row to the
-     * left */
-    if (emptyCellCounter) {
-        for (int col = c; col < LAST_INTERIOR_CELL_COLUMN; col += 2) {
-	    game->board[game->rowMove][col] =
-		    game->board[game->rowMove][col + 2];
-	}
+void finish_move(Game* game, char player) {
+    // Record the move, then display the move (if need be) and the board
+    game->moveCount++;
+    if (game->journal) {
+	journal_move(game, player);
+    }
+    print_frame(game, player);
+}
 
-	// Last cell must have value of player who made pushing cell move
-	game->board[game->rowMove][LAST_INTERIOR_CELL_COLUMN] =
-		game->currentPlayer;
+PushDirection push_direction(Game* game) {
+    // Same order as push_move
+    if (game->rowMove == game->rows - 1) {
+	return PUSH_UP;
+    } else if (game->rowMove == 0) {
+	return PUSH_DOWN;
+    } else if (game->columnMove == game->columns - 1) {
+	return PUSH_LEFT;
+    } else if (game->columnMove == 0) {
+	return PUSH_RIGHT;
+    }
+    return PUSH_NONE;
+}
 
-	// If automated player (i.e. type 1) pushed cell, display move
-	if ((game->currentPlayer == 'O' && game->playerTypeO != 'H') ||
-		(game->currentPlayer == 'X' && game->playerTypeX != 'H')) {
-	    printf("Player %c placed at %ld %ld\n", game->currentPlayer,
-		    game->rowMove, game->columnMove);
-	}
+void start_journal(Game* game) {
+    if (!game->options.journalName || game->options.batch) {
+	return;
+    }
 
-	// Print board
-	for (int r = 0; r < game->rows; r++) {
-	    printf("%s\n", game->board[r]);
+    /* A journal the game was loaded from is carried on from its last whole
+     * move */
+    if (game->journalResume) {
+	game->journal = fopen(game->options.journalName, "r+b");
+	if (!game->journal ||
+		ftruncate(fileno(game->journal), game->journalResume) ||
+		fseek(game->journal, game->journalResume, SEEK_SET)) {
+	    journal_failed(game);
 	}
+	return;
+    }
+    game->journal = fopen(game->options.journalName, "wb");
+    if (!game->journal) {
+	journal_failed(game);
+	return;
+    }
 
-	// Swap current player for next move
-	game->currentPlayer = (game->currentPlayer == 'X') ? 'O' : 'X';
+    // The journal starts with the whole initial position, see JOURNAL_MAGIC
+    char* out = game->frame;
+    memcpy(out, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE);
+    out += JOURNAL_MAGIC_SIZE;
+    *out++ = JOURNAL_VERSION;
+    memset(out, 0, JOURNAL_HEADER_SIZE - JOURNAL_MAGIC_SIZE - 1);
+    out += JOURNAL_HEADER_SIZE - JOURNAL_MAGIC_SIZE - 1;
+    out = render_binary(game, out);
+    if (fwrite(game->frame, 1, out - game->frame, game->journal) !=
+	    (size_t)(out - game->frame) || fflush(game->journal)) {
+	journal_failed(game);
     }
 }
 
-void push_right(Game* game, int emptyCellCounter, int c) {
-    // Ensure row isn't full - start at 2 cells after the move (i.e. 4 chars)
-    for (c = MOVE_INDEX + 4; c < 2 * game->columns; c++) {
-        if (game->board[game->rowMove][c] == '.') {
-	    emptyCellCounter++;
-	    break;
-	}
+void journal_move(Game* game, char player) {
+    char record[JOURNAL_RECORD_SIZE] = {0};
+    char* out = write_binary_u32(record, (uint32_t)game->rowMove);
+    out = write_binary_u32(out, (uint32_t)game->columnMove);
+    *out++ = player;
+    *out = push_direction(game);
+
+    /* Flush each move as it is made, so that the journal is always complete
+     * up to the last move */
+    if (fwrite(record, 1, JOURNAL_RECORD_SIZE, game->journal) !=
+	    JOURNAL_RECORD_SIZE || fflush(game->journal)) {
+	journal_failed(game);
     }
+}
 
-    /* If row isn't full, go to first empty cell and set it equal to the value
-     * of the cell left of it, effectively pushing all cells in row to the
-     * right */
-    if (emptyCellCounter) {
-	// Push right until cell immediately before the player's cell move
-        for (int col = c; col > MOVE_INDEX + 2; col -= 2) {
-	    game->board[game->rowMove][col] =
-		    game->board[game->rowMove][col - 2];
-	}
+void journal_failed(Game* game) {
+    fprintf(stderr, "Journal failed\n");
+    if (game->journal) {
+	fclose(game->journal);
+	game->journal = 0;
+    }
+}
 
-	// Last cell must have value of player who made pushing cell move
-	game->board[game->rowMove][MOVE_INDEX + 2] =
-		game->currentPlayer;
+int same_file(const char* first, const char* second) {
+    struct stat firstInfo, secondInfo;
+    return !stat(first, &firstInfo) && !stat(second, &secondInfo) &&
+	    firstInfo.st_dev == secondInfo.st_dev &&
+	    firstInfo.st_ino == secondInfo.st_ino;
+}
 
-	// If automated player (i.e. type 1) pushed cell, display move
-	if ((game->currentPlayer == 'O' && game->playerTypeO != 'H') ||
-		(game->currentPlayer == 'X' && game->playerTypeX != 'H')) {
-	    printf("Player %c placed at %ld %ld\n", game->currentPlayer,
-		    game->rowMove, game->columnMove);
-	}
+int replay_journal(Game* game, LoadedFile* gameFile, ExitCodes* exitStatus) {
+    if (!gameFile->journal) {
+	return *exitStatus;
+    }
 
-	// Print board
-	for (int r = 0; r < game->rows; r++) {
-	    printf("%s\n", game->board[r]);
+    /* Replay each whole move (a move cut short, e.g. by a crash, is
+     * ignored) through the same kernels as the moves of a game, without
+     * displaying anything */
+    Verbosity verbosity = game->verbosity;
+    game->verbosity = VERBOSITY_NONE;
+    int valid = 1;
+    while (valid &&
+	    gameFile->size - gameFile->position >= JOURNAL_RECORD_SIZE) {
+	const unsigned char* record =
+		(const unsigned char*)gameFile->contents + gameFile->position;
+	gameFile->position += JOURNAL_RECORD_SIZE;
+	char player = game->currentPlayer;
+	game->rowMove = read_binary_u32(record);
+	game->columnMove = read_binary_u32(record + 4);
+
+	/* Each move must be made by the current player, be legal, and push
+	 * the way it was recorded to */
+	valid = !check_board_full(game) && record[8] == player &&
+		record[9] == push_direction(game);
+	if (valid) {
+	    play_move("", "", game);
+	    valid = game->currentPlayer != player;
 	}
+    }
+    game->verbosity = verbosity;
 
-	// Swap current player for next move
-	game->currentPlayer = (game->currentPlayer == 'X') ? 'O' : 'X';
+    if (!valid) {
+	fprintf(stderr, "Invalid file contents\n");
+	*exitStatus = EXIT_FILE_CONTENTS;
     }
+    return *exitStatus;
 }
 
-void save_game(char** rowMoveErrors, char** columnMoveErrors, char** move,
-	Game* game) {
-    // Set below to sentinel values for play_move to process
+void save_game(char* fileName, Game* game) {
+    // Set below to sentinel values (a corner) for play_move to process
     game->rowMove = game->columnMove = 0;
-    *rowMoveErrors = *columnMoveErrors = "";
 
     // Ensure simply 's' isn't input
-    if (strlen(*move) > 1) {
-	FILE* saveFile = fopen(*move + 1, "w");
+    if (*fileName) {
+	FILE* saveFile = fopen(fileName, "w");
 
 	// Check if fopen failed to open the fail
 	if (!saveFile) {
@@ -1009,21 +3882,34 @@ void save_game(char** rowMoveErrors, char** columnMoveErrors, char** move,
 	    return;
 	}
 	    
-	// Write to save file
-	fprintf(saveFile, "%ld %ld\n", game->rows, game->columns);
-	fprintf(saveFile, "%c\n", game->currentPlayer);
-	for (int r = 0; r < game->rows; r++) {
-	    fprintf(saveFile, "%s\n", game->board[r]);
+	/* Write to save file, all at once. Files named with BINARY_EXTENSION
+	 * are saved in the binary format, otherwise as text. */
+	char* out = game->frame;
+	size_t nameLength = strlen(fileName);
+	if (nameLength >= strlen(BINARY_EXTENSION) && !strcmp(fileName +
+		nameLength - strlen(BINARY_EXTENSION), BINARY_EXTENSION)) {
+	    out = render_binary(game, out);
+	} else {
+	    out += sprintf(out, "%ld %ld\n%c\n", game->rows, game->columns,
+		    game->currentPlayer);
+	    out = render_board(game, out);
 	}
+	fwrite(game->frame, 1, out - game->frame, saveFile);
 	fflush(saveFile);
 	fclose(saveFile);
     }
 }
 
-void game_over(Game* game, char* rowsAndColumns, FILE* gameFile) {
-    int scoreO, scoreX;
-
-    current_score_calc(&scoreO, &scoreX, game);
+void game_over(Game* game) {
+    int scoreO = game->scoreO;
+    int scoreX = game->scoreX;
+    report_search("Type 3 players", game->stats.searchIterations,
+	    game->stats.searchSeconds);
+    report_timed("Type 2 players", game->stats.timedMoves,
+	    game->stats.timedDepths, game->stats.timedNodes,
+	    game->stats.timedSeconds, game->stats.timedSlowest);
+    report_solve("Endgame", game->stats.solveMoves, game->stats.solveNodes,
+	    game->stats.solveSeconds, game->stats.solveSlowest);
 
     // Assign current player to be the winner
     game->currentPlayer = (scoreX > scoreO) ? 'X' : 'O';
@@ -1034,17 +3920,37 @@ void game_over(Game* game, char* rowsAndColumns, FILE* gameFile) {
     } else {
         printf("Winners: %c\n", game->currentPlayer);
     }
-    
-    free(rowsAndColumns);
+
     game_free_memory(game);
-    fclose(gameFile);
 }
 
 void game_free_memory(Game* game) {
-    for (int r = 0; r < game->rows; r++) {
-	free(game->board[r]);
+    if (game->journal) {
+	fclose(game->journal);
+    }
+    free(game->input.data);
+    free(game->table);
+    if (game->helperPool) {
+	free_helpers(game);
+    }
+    if (game->sharedTable) {
+	free(game->sharedTable->words);
+	free(game->sharedTable);
+    }
+    free(game->searchMoves);
+    for (int t = 0; t < game->searcherCount; t++) {
+	if (game->searchers[t].game) {
+	    game_free_memory(game->searchers[t].game);
+	    free(game->searchers[t].rootState);
+	    free(game->searchers[t].nodes);
+	}
+    }
+    free(game->searchers);
+    if (game->tablebase.contents) {
+	close_file(&game->tablebase);
     }
 
-    free(game->board);
+    // The whole board was allocated at once in alloc_arena
+    free(game->arena);
     free(game);
 }
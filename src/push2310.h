@@ -6,13 +6,297 @@ typedef enum {
     EXIT_FILE_READ = 3,
     EXIT_FILE_CONTENTS = 4,
     EXIT_EOF = 5,
-    EXIT_FULL_BOARD = 6
+    EXIT_FULL_BOARD = 6,
+    EXIT_TABLEBASE = 7
 } ExitCodes;
 
+/* How much of the game is displayed: every frame (i.e. the move made and the
+ * board after every move, the default), only the moves made, only the final
+ * result, only what each move changed (see render_delta), or nothing at all
+ * (e.g. while a journal is replayed) */
+typedef enum {
+    VERBOSITY_FRAMES = 0,
+    VERBOSITY_MOVES = 1,
+    VERBOSITY_RESULT = 2,
+    VERBOSITY_DELTA = 3,
+    VERBOSITY_NONE = 4
+} Verbosity;
+
+/* The direction a move pushes stones in, if any, as recorded in a journal */
+typedef enum {
+    PUSH_NONE = 0,
+    PUSH_UP = 1,
+    PUSH_DOWN = 2,
+    PUSH_LEFT = 3,
+    PUSH_RIGHT = 4
+} PushDirection;
+
+/* The state of a cell in a binary save file */
+typedef enum {
+    CELL_EMPTY = 0,
+    CELL_O = 1,
+    CELL_X = 2
+} CellState;
+
+/* Bitboard word - each bit of a word flags a single cell of a board row */
+typedef uint64_t BoardWord;
+
+/* Number of cells flagged by a single bitboard word */
+#define WORD_BITS 64
+
+/* Size of a cache line, in bytes and in bitboard words */
+#define CACHE_LINE_BYTES 64
+#define CACHE_LINE_WORDS ((long int)(CACHE_LINE_BYTES / sizeof(BoardWord)))
+
+/* Rounds a size in bytes up to a whole number of cache lines */
+#define CACHE_LINE_ROUND(size) \
+	(((size) + CACHE_LINE_BYTES - 1) / CACHE_LINE_BYTES * CACHE_LINE_BYTES)
+
+/* The SSE2 and AVX2 kernels (see Kernels) can only be built for x86, only
+ * the scalar kernels are built elsewhere */
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86
+#endif
+
+/* Whether a character of a loaded row is a cell's stone (or a dot) */
+#define STONE_CHAR(ch) ((ch) == '.' || (ch) == 'O' || (ch) == 'X')
+
+/* Size of the blocks a save file is read in, when it cannot be mapped into
+ * memory (e.g. when it is a pipe) */
+#define LOAD_BLOCK_SIZE 65536
+
+/* Loaded File - The whole contents of a save file, and how far through the
+ * contents the file has been parsed. The contents are either mapped into
+ * memory (mapped is 1) or read into a malloc'd buffer (mapped is 0), and are
+ * NOT null terminated. journal is 1 if the file is a journal (see
+ * JOURNAL_MAGIC). */
+typedef struct {
+    char* contents;
+    size_t size;
+    size_t position;
+    int mapped;
+    int journal;
+} LoadedFile;
+
+/* Size of the blocks stdin is read in */
+#define INPUT_BLOCK_SIZE 65536
+
+/* Input Buffer - Input read in from stdin, a block at a time, which is split
+ * into lines in place. data holds capacity chars (and is only grown for
+ * lines that don't fit), of which the chars from start to end have been read
+ * in but not yet returned. eof is 1 once stdin has run out, and interactive
+ * is 1 if stdin and stdout are a terminal. */
+typedef struct {
+    char* data;
+    size_t capacity;
+    size_t start;
+    size_t end;
+    int eof;
+    int interactive;
+} InputBuffer;
+
+/* Which bound of a position's value a transposition table entry holds */
+typedef enum {
+    BOUND_EXACT = 0,
+    BOUND_LOWER = 1,
+    BOUND_UPPER = 2
+} Bound;
+
+/* Table Entry - What a type 2 player's search found for a position (see
+ * negamax): the key of the position, the best move found, its value (or a
+ * bound on it), and the depth it was searched to */
+typedef struct {
+    uint64_t key;
+    int32_t row;
+    int32_t column;
+    int32_t value;
+    int16_t depth;
+    int16_t bound;
+} TableEntry;
+
+/* Shared Table - A transposition table shared by the threads of a type 2
+ * player's search (see start_helpers), without locks. Each of its
+ * TABLE_SIZE entries is TABLE_WORDS words: the key XORed with the other two
+ * words, the value, depth and bound (and the age of the search that stored
+ * them), and the best move. Threads read and write the words one at a time,
+ * so an entry torn by two threads writing it at once fails the check of its
+ * key and is ignored. age counts the moves searched with the table, and
+ * entries stored for earlier moves are replaced first (see table_store). */
+typedef struct {
+    uint64_t* words;
+    uint8_t age;
+} SharedTable;
+
+/* Number of entries in a type 2 player's transposition table (a power of
+ * two), the depth searched to unless another is given (see --depth), a value
+ * beyond any score difference, how early pushes are tried (see
+ * order_moves), and how many positions are searched between looks at the
+ * clock when the search has a deadline (a power of two) */
+#define TABLE_SIZE (1 << 18)
+#define SEARCH_DEPTH 3
+#define SEARCH_INFINITY 1000000
+#define PUSH_ORDER 8
+#define SEARCH_CHECK_NODES 16
+#define TABLE_WORDS 3
+
+/* The default policy a type 3 player's playouts follow (see --playout): the
+ * moves of a type 0 player or of a type 1 player */
+typedef enum {
+    PLAYOUT_ZERO = 0,
+    PLAYOUT_ONE = 1
+} Playout;
+
+/* Number of iterations a type 3 player's search runs for each move unless
+ * another budget is given (see --iterations and --move-time-ms), how much
+ * the search explores moves that haven't done well so far (the UCT
+ * exploration constant), and how often a playout takes a random move rather
+ * than the move of its policy (one move in MCTS_RANDOM_MOVES) */
+#define MCTS_ITERATIONS 2000
+#define MCTS_EXPLORATION 1.4
+#define MCTS_RANDOM_MOVES 8
+
+/* Move - A legal move (see generate_moves): the row and column of the cell
+ * played, the direction the move pushes stones in (a PushDirection, being
+ * PUSH_NONE for a placement, otherwise the line pushed is the row or column
+ * of the cell), and how early a search is to try it (see order_moves) */
+typedef struct {
+    int32_t row;
+    int32_t column;
+    int16_t order;
+    uint8_t push;
+} Move;
+
+/* Undo - What make_move changed, so that unmake_move can change it back: the
+ * move made (whose cell was empty), and for a push, the lowest and highest
+ * cells of the pushed line that moved (the cell at the far end, in the
+ * direction of the push, being the empty cell the push filled) */
+typedef struct {
+    Move move;
+    int32_t low;
+    int32_t high;
+} Undo;
+
+/* Line Sums - The opponent's score from the stones of a line that a type one
+ * push would move (score), and what that score would be once those stones
+ * were pushed one cell along (pushed) */
+typedef struct {
+    int score;
+    int pushed;
+} LineSums;
+
+/* Column Sums - The running sums of one column while type_one_sweep sweeps
+ * the board from the top row down: the stones reachable from the top border
+ * (down, which is only added to while reachable is set), and the stones since
+ * the last empty cell (up, which once the sweep is done are the stones
+ * reachable from the bottom border) */
+typedef struct {
+    LineSums down;
+    LineSums up;
+    int reachable;
+} ColumnSums;
+
+/* Tablebase Slot - A position solved while making a tablebase, laid out as
+ * a slot of the file is (see TABLEBASE_MAGIC) */
+typedef struct {
+    uint64_t key;
+    int32_t value;
+    uint32_t move;
+} TablebaseSlot;
+
+/* Tablebase - The positions solved so far while making a tablebase, in an
+ * open addressing hash table of slotCount slots (a power of two), of which
+ * count are used. failed is set (and no more positions are added) if the
+ * slots couldn't be doubled. */
+typedef struct {
+    TablebaseSlot* slots;
+    uint64_t slotCount;
+    uint64_t count;
+    int failed;
+} Tablebase;
+
+/* The most legal moves a position can have, being one for every cell other
+ * than the corners (i.e. a placement on every interior cell and a push from
+ * every border cell), and hence the size of a move list */
+#define MOVE_CAPACITY (game->rows * game->columns - 4)
+
+/* Kernels - The loops over whole rows of the board, written once for each
+ * instruction set (named by name) and selected when the program runs (see
+ * find_kernels), which all give exactly the same results:
+ *  - textValid checks that the even characters of some text (the score
+ *    characters of a loaded row) are from low to high, and that the odd
+ *    characters are stones or dots. Returns 1 if so, otherwise 0. The length
+ *    of the text must be even.
+ *  - decodeScores decodes the score characters of the first cells of a
+ *    loaded row into scores, with anything but a digit being a score of 0.
+ *  - decodeStones sets the bits of cellsO and cellsX (which are a bitboard
+ *    row, see Game) for the O and X stones of the first cells of a loaded row.
+ *  - sumScores returns the total score of the cells whose bits are set in
+ *    the words of a bitboard row, given the scores of that row. */
+typedef struct {
+    const char* name;
+    int (*textValid)(const char* text, long int length, char low, char high);
+    void (*decodeScores)(const char* row, long int cells, uint8_t* scores);
+    void (*decodeStones)(const char* row, long int cells, BoardWord* cellsO,
+	    BoardWord* cellsX);
+    int (*sumScores)(const uint8_t* scores, const BoardWord* cells,
+	    long int words);
+} Kernels;
+
+/* Options - How a game is played, as set on the command line (see
+ * options_handler): whether save files are played as a batch or a
+ * tournament, how many threads search (or play a tournament), the budgets of
+ * the automated players' searches and the playout policy of type 3 players,
+ * how many empty cells type 1 to 3 players solve the game from, the
+ * tablebase used (and the one made instead of playing), how deep the game
+ * tree is counted and how many times the kernels are timed instead of
+ * playing, the kernels used (the fastest if not set), and the journal
+ * written. An option is 0 (or NULL) if it wasn't given. */
+typedef struct {
+    int batch;
+    int tournament;
+    int threads;
+    int searchDepth;
+    long int solveCells;
+    long int iterations;
+    long int moveTimeMs;
+    Playout playout;
+    char* tablebaseName;
+    char* tablebaseOut;
+    int perftDepth;
+    long int benchPasses;
+    const Kernels* kernels;
+    char* journalName;
+} Options;
+
+/* Stats - What the automated players' searches did over a game, as reported
+ * once it is over: the iterations the searches of type 3 players ran and how
+ * many seconds they took (see report_search), how many moves type 2 players
+ * searched against the clock, the total of the depths they completed, the
+ * nodes searched (by every thread) and the seconds taken in total and at
+ * most (see report_timed), and how many moves were solved exactly, the nodes
+ * searched solving them, and the seconds taken in total and at most (see
+ * report_solve). */
+typedef struct {
+    long int searchIterations;
+    double searchSeconds;
+    long int timedMoves;
+    long int timedDepths;
+    long int timedNodes;
+    double timedSeconds;
+    double timedSlowest;
+    long int solveMoves;
+    long int solveNodes;
+    double solveSeconds;
+    double solveSlowest;
+} Stats;
+
 /* Game Representation - Stores all information
  * about the board and the players. */
 typedef struct {
-    char** board;
+    char* arena;
+    const char** loadedRows;
+    const unsigned char* loadedScores;
+    const unsigned char* loadedStates;
     char playerTypeO;
     char playerTypeX;
     char currentPlayer;
@@ -20,8 +304,181 @@ typedef struct {
     long int columns;
     long int rowMove;
     long int columnMove;
+    long int rowWords;
+    BoardWord* stonesO;
+    BoardWord* stonesX;
+    long int columnWords;
+    BoardWord* stonesByColumnO;
+    BoardWord* stonesByColumnX;
+    long int* rowStones;
+    long int* columnStones;
+    BoardWord* interiorMask;
+    long int emptyCells;
+    BoardWord* emptyRows;
+    long int* rowEmpties;
+    uint8_t* scores;
+    uint64_t* zobrist;
+    Move* moves;
+    ColumnSums* columnSums;
+    BoardWord* pushColumns;
+    size_t arenaSize;
+    size_t stateSize;
+    int scoreO;
+    int scoreX;
+    uint64_t key;
+    char* frame;
+    Verbosity verbosity;
+    long int moveCount;
+    Options options;
+    Stats stats;
+    long int searchNodes;
+    int deadlineSet;
+    struct timespec deadline;
+    int searchStopped;
+    int* stopFlag;
+    LoadedFile tablebase;
+    uint64_t tablebaseSlots;
+    TableEntry* table;
+    SharedTable* sharedTable;
+    Move* searchMoves;
+    int searchPlies;
+    struct Searcher* searchers;
+    int searcherCount;
+    struct HelperPool* helperPool;
+    FILE* journal;
+    long int journalResume;
+    InputBuffer input;
 } Game;
 
+/* Game Result - The outcome of a game played without being displayed (see
+ * play_headless_game). If the game couldn't be played, status is the exit
+ * status for the error and the rest is unset. Otherwise the winner is 'O',
+ * 'X', or 'D' for a draw, key is the key of the final position, and stats
+ * are what the automated players' searches did. */
+typedef struct {
+    ExitCodes status;
+    char winner;
+    int scoreO;
+    int scoreX;
+    long int moveCount;
+    uint64_t key;
+    Stats stats;
+} GameResult;
+
+/* Tally - The results of every game played with a pairing of player types,
+ * the number of save files that couldn't be played, and what the searches
+ * of the games played did (see add_stats) */
+typedef struct {
+    long int games;
+    long int winsO;
+    long int winsX;
+    long int draws;
+    long int errors;
+    Stats stats;
+} Tally;
+
+/* Node - A position in a type 3 player's search tree (see mcts_search):
+ * the move that leads to it and the player who made said move, its parent,
+ * its children (childCount nodes from firstChild, childCount being -1 until
+ * the node is expanded), the number of playouts made through it, and the
+ * total result of said playouts for the player who made the move (1 for a
+ * win, 0.5 for a draw). Nodes refer to each other by their index. */
+typedef struct {
+    int32_t row;
+    int32_t column;
+    int32_t parent;
+    int32_t firstChild;
+    int32_t childCount;
+    int32_t visits;
+    float wins;
+    char player;
+} Node;
+
+/* Searcher - A thread searching for a type 3 player's move. Each searcher
+ * has a copy of the game (see copy_game) to play moves on, the position to
+ * search from (its packed state and running totals, which each iteration
+ * starts from after a whole playout), a search tree of its own (nodeCount
+ * nodes, with room for nodeCapacity), the state of its random numbers, and
+ * how many iterations it may run (and until when, if deadline is set). A
+ * game's searchers are kept from move to move, so only the position and
+ * the tree are set up again for each move. */
+typedef struct Searcher {
+    Game* game;
+    char* rootState;
+    int rootScoreO;
+    int rootScoreX;
+    long int rootEmptyCells;
+    char rootPlayer;
+    uint64_t rootKey;
+    Node* nodes;
+    int32_t nodeCount;
+    int32_t nodeCapacity;
+    uint64_t random;
+    long int iterations;
+    int deadlineSet;
+    struct timespec deadline;
+} Searcher;
+
+/* Helper - A thread helping a type 2 player search (see start_helpers),
+ * with a copy of the game (see copy_game) sharing the player's transposition
+ * table and stop flag, the depth it starts searching from, the thread it
+ * runs on, the pool it belongs to, and the last move it was woken for. */
+typedef struct {
+    Game* game;
+    int firstDepth;
+    pthread_t thread;
+    struct HelperPool* pool;
+    unsigned long int generation;
+} Helper;
+
+/* Helper Pool - The helpers of a game's type 2 players, made on the first
+ * move searched with them and kept until the game is freed (see
+ * free_helpers). Under its lock, generation counts the moves the helpers
+ * have been woken for (through start), busy how many of them are still
+ * searching the current move (waited for through done), and quit tells
+ * them to exit. stopFlag tells them to stop searching, and is read without
+ * the lock. */
+typedef struct HelperPool {
+    Helper* helpers;
+    int helperCount;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long int generation;
+    int busy;
+    int quit;
+    int stopFlag;
+} HelperPool;
+
+struct Tournament;
+
+/* Worker - A thread playing the games of a tournament. Each worker has a
+ * deque of tasks (being the tasks from top to bottom, see play_tournament),
+ * which is guarded by its lock, and its own tally for every pairing of
+ * player types. */
+typedef struct {
+    struct Tournament* tournament;
+    int id;
+    pthread_mutex_t lock;
+    long int top;
+    long int bottom;
+    Tally* tallies;
+} Worker;
+
+/* Tournament - Every save file to be played with every pairing of player
+ * types (a type from typesO for player O and a type from typesX for player
+ * X), and the workers playing them. */
+typedef struct Tournament {
+    char** fileNames;
+    size_t fileCount;
+    char* typesO;
+    char* typesX;
+    int pairingCount;
+    Game* settings;
+    Worker** workers;
+    int workerCount;
+} Tournament;
+
 /* To understand the internal game representation of the board, consider the
  * following example:
  *   0.0.0.0.
@@ -29,89 +486,384 @@ typedef struct {
  * 0.3.2.4.5X0.
  * 0.4.1.2.6.0.
  *   7.7.9.9.  
- * The game board is represented via a dynamic 2D char** array in which each
- * element is a char. Hence, each character in the game board is individually
- * indexed (as opposed to the user's end, in which only the empty cells (i.e.
- * the dots) can be accessed. Hence, as indexing commences from 0, and each
- * row begins either with 2 blank spaces (i.e. the first and last row), or a
- * 0, each even index of the columns refers to a score value, and each odd
- * index refers to either an X, an O, or a . (empty cell). For example, the
- * move that player X has made, in the game would correspond to 2 4. However,
- * as each character is indexed in the internal game representation, the move
- * 2 4 would correspond to index [2][9], to account for each character.
- * Similarly, player O's move, to the user, would correspond to move 1 2, but
- * in the internal game representation, the array index would be [1][5] */
-
-/* Based on the above explanation, consider the following. By definition, an
- * odd integer n is equal to 2 * k + 1 for some integer k, and this can be
- * seen in the above examples (here, k is the column number). */
-#define MOVE_INDEX 2 * game->columnMove + 1
-
-/* As the definition of an odd number is n = 2 * k + 1 for integers n and k,
- * in some cases we may like to find k. In this case,
- * c = 2 * game->columnMove + 1, and we must find game->columnMove. c is odd
- * by definition hence the division below does not cause issues with integer
- * division. */
-#define COLUMN_MOVE (c - 1) / 2 
-
-/* As each cell contains both a score value and either an empty dot, or a
- * player's stone, there are (2 * game->columns) columns in the game under the
- * internal game representation. Hence, as we index from 0, the final interior
- * playing cells (wheter an empty dot or a player's stone), in each row are
- * given by the the following. */
-#define LAST_INTERIOR_CELL_COLUMN 2 * game->columns - 3
-
-/* By the same logic above, the column index immediately before the above
- * would correspond to the score of the last interior cell column.
- * Factorising this expression leads to the following. */
-#define SCORE_COLUMN_OF_LAST_INTERIOR_CELL 2 * (game->columns - 2)
-
-/* By the same logic above, the column index immediately before the above
- * would correspond to the playing cell of the second last interior cell
- * column. Expanding this expression leads to the following. */
-#define SECOND_LAST_INTERIOR_CELL_COLUMN 2 * game->columns - 5
-
-/* By the same logic as LAST_INTERIOR_CELL_COLUMN, the cells at
+ * The text above is only ever read while loading a save file (where
+ * game->loadedRows points to the start of each row within the loaded file,
+ * which is validated and then packed by pack_board), and is produced again (in
+ * game->frame, see FRAME_SIZE) when the board is printed or saved. While the
+ * game is being played the board is instead stored as packed state, indexed
+ * by cell rather than by character, so that the move for player X above is
+ * simply row 2, column 4:
+ *  - stonesO and stonesX are occupancy bitmasks, one per player. Each board
+ *    row takes up game->rowWords words (which may include unused words at
+ *    the end of the row, see alloc_arena), and bit (c % WORD_BITS) of word
+ *    (c / WORD_BITS) of a row is set if the player has a stone in column c.
+ *  - stonesByColumnO and stonesByColumnX hold the same stones column by
+ *    column, with game->columnWords words per column and bit
+ *    (r % WORD_BITS) of word (r / WORD_BITS) of a column set if the player
+ *    has a stone in row r. Every line of the board (row or column) is hence
+ *    a run of bits, which a push can shift along a word at a time.
+ *  - rowStones and columnStones count the stones (of both players, border
+ *    cells included) in each row and column, so whether a line has room for
+ *    a push is a single comparison.
+ *  - interiorMask is a single row's worth of words with a bit set for every
+ *    interior column (i.e. 1 to game->columns - 2), which allows the
+ *    interior of a row to be tested a word at a time.
+ *  - scores holds the score value of every cell, row by row, with
+ *    SCORE_STRIDE values per row (i.e. one for every bit of a bitboard row).
+ *    Corner cells have a score of 0.
+ *  - scoreO and scoreX are the current scores of each player. These are
+ *    kept up to date by set_cell as stones are placed and pushed, rather than
+ *    being recalculated from the whole board.
+ *  - emptyCells, emptyRows and rowEmpties index the empty interior cells,
+ *    and are also kept up to date by set_cell. emptyCells is the number of
+ *    empty interior cells, rowEmpties is the number of empty interior cells
+ *    in each row, and bit (r % WORD_BITS) of word (r / WORD_BITS) of
+ *    emptyRows is set if row r has at least one empty interior cell. Hence
+ *    the first (or last) empty cell of the board is found from the lowest
+ *    (or highest) bit of emptyRows, and then of the empty cells in said row.
+ *  - moves is room for a list of every legal move (see generate_moves), and
+ *    columnSums and pushColumns for the sums of every column and the columns
+ *    that can be pushed along (see type_one_sweep).
+ *  - key is the Zobrist key of the position, which identifies the board
+ *    (its dimensions and scores), the stones on it, and the player to move.
+ *    zobrist holds a random key for each player's stone on each cell (see
+ *    ZOBRIST_AT), and the key of a position is the key of the board, XORed
+ *    with the key of every stone and with ZOBRIST_PLAYER_X if X is to move.
+ *    Hence key is kept up to date by XORing in the changes of each move
+ *    (see set_cell, mirror_changes and make_move).
+ * All of the above (and the loaded text) is allocated in one block,
+ * game->arena, with each part starting on a cache line. Everything that a
+ * move can change comes first, in the first game->stateSize bytes of the
+ * arena (starting at game->stonesO), so that a position can be saved and
+ * restored with a single copy. */
+
+/* While loading, each character in the game board is individually indexed
+ * (as opposed to the user's end, in which only the empty cells (i.e. the
+ * dots) can be accessed). Hence, as indexing commences from 0, and each row
+ * begins either with 2 blank spaces (i.e. the first and last row), or a 0,
+ * each even index of the loaded columns refers to a score value, and each odd
+ * index refers to either an X, an O, or a . (empty cell). As each cell
+ * contains both a score value and either an empty dot, or a player's stone,
+ * there are (2 * game->columns) columns in a loaded row, and the cells at
  * 2 * game->columns - 2 are the score values of the final column. This can be
  * represented by the following. */
 #define SCORE_COLUMN_OF_LAST_CELL 2 * (game->columns - 1)
 
 /* By the same logic as SCORE_COLUMN_OF_LAST_CELL, the cells at
- * 2 * game->columns - 1 represent the final column of the game board. */
+ * 2 * game->columns - 1 represent the final column of the loaded board. */
 #define LAST_CELL_COLUMN 2 * game->columns - 1
 
+/* The first word of row r of a bitboard (i.e. stonesO or stonesX) */
+#define ROW_WORDS_OF(bitboard, r) ((bitboard) + (r) * game->rowWords)
+
+/* The first word of column c of a column bitboard (i.e. stonesByColumnO or
+ * stonesByColumnX) */
+#define COLUMN_WORDS_OF(bitboard, c) ((bitboard) + (c) * game->columnWords)
+
+/* The bit flagging column c within its word of a bitboard row (or row c
+ * within its word of a bitboard column) */
+#define CELL_BIT(c) ((BoardWord)1 << ((c) % WORD_BITS))
+
+/* The key (see game->key) of a stone of player stone on the cell at row r,
+ * column c */
+#define ZOBRIST_AT(r, c, stone) \
+	(game->zobrist[2 * ((r) * game->columns + (c)) + ((stone) == 'X')])
+
+/* The key XORed into a position's key when player X is to move */
+#define ZOBRIST_PLAYER_X 0xD1B54A32D192ED03ULL
+
+/* The number of score values in each row of game->scores */
+#define SCORE_STRIDE (game->rowWords * WORD_BITS)
+
+/* The score value of the cell at row r, column c */
+#define SCORE_AT(r, c) (game->scores[(r) * SCORE_STRIDE + (c)])
+
+/* Size of game->frame, enough for the move made (or the first two lines of a
+ * save file), each row of the board followed by a new line, and the null
+ * character written by sprintf */
+#define FRAME_SIZE (64 + game->rows * (2 * game->columns + 1) + 1)
+
+/* The loaded character at row r, index c of the loaded text board */
+#define LOADED_AT(r, c) (game->loadedRows[r][c])
+
+/* Save files can also be in a binary format, which is made up of:
+ *  - a header of BINARY_HEADER_SIZE bytes, being BINARY_MAGIC, the format
+ *    version (BINARY_VERSION), the current player ('O' or 'X'), two unused
+ *    bytes, the rows and the columns as little endian 32 bit numbers, and
+ *    then the key of the position (see zobrist_hash) as a little endian 64
+ *    bit number. The key is only there to identify the position without
+ *    loading it, and is not read when loading. Version 1 files (which are
+ *    still loaded) have a header of BINARY_V1_HEADER_SIZE bytes, without the
+ *    key.
+ *  - the score of each cell in row-major order, two cells per byte (the
+ *    first cell in the low 4 bits)
+ *  - the state of each cell (a CellState) in row-major order, four cells
+ *    per byte (the first cell in the low 2 bits)
+ * Binary save files are recognised by their magic bytes when loading, and
+ * are written when saving to a file whose name ends in BINARY_EXTENSION. */
+#define BINARY_MAGIC "P2SB"
+#define BINARY_MAGIC_SIZE 4
+#define BINARY_VERSION 2
+#define BINARY_HEADER_SIZE 24
+#define BINARY_V1_HEADER_SIZE 16
+#define BINARY_EXTENSION ".p2b"
+
+/* A journal records a whole game as it is played, and is made up of:
+ *  - a header of JOURNAL_HEADER_SIZE bytes, being JOURNAL_MAGIC, the format
+ *    version (JOURNAL_VERSION), and three unused bytes
+ *  - the initial position, as a binary save file
+ *  - one record of JOURNAL_RECORD_SIZE bytes per move, being the row and the
+ *    column as little endian 32 bit numbers, the player ('O' or 'X'), the
+ *    push direction (a PushDirection), and two unused bytes
+ * A journal is written (see --journal) with each move flushed as it is made,
+ * and is recognised by its magic bytes when loading, in which case the moves
+ * are replayed on top of the initial position. */
+#define JOURNAL_MAGIC "P2SJ"
+#define JOURNAL_MAGIC_SIZE 4
+#define JOURNAL_VERSION 1
+#define JOURNAL_HEADER_SIZE 8
+#define JOURNAL_RECORD_SIZE 12
+
+/* A tablebase holds the exact value and best move of every position
+ * reachable from a save file (see make_tablebase), and is made up of:
+ *  - a header of TABLEBASE_HEADER_SIZE bytes, being TABLEBASE_MAGIC, the
+ *    format version (TABLEBASE_VERSION), three unused bytes, the number of
+ *    rows and of columns (32 bits each), the key of the board (see
+ *    board_key), and the number of slots (64 bits, a power of two)
+ *  - the slots, an open addressing hash table of TABLEBASE_SLOT_SIZE bytes
+ *    per slot, being the key of a position (0 if the slot is empty), its
+ *    value (the final score difference for the player to move, as a 32 bit
+ *    two's complement number), and its best move (row * columns + column,
+ *    32 bits)
+ * All numbers are little endian. A position is found from the slot indexed
+ * by the low bits of its key, moving on to the next slot (wrapping around)
+ * until the key or an empty slot is found, and at most half of the slots are
+ * used. A tablebase is used (see --tablebase) by mapping it into memory.
+ * The offsets are those of each field within the header and within a slot.
+ * Tablebases are only made for boards on which at most TABLEBASE_MAX_MOVES
+ * moves can still be made, as the positions roughly triple with every move
+ * (24 moves being some five million positions, and 256 MB). */
+#define TABLEBASE_MAGIC "P2TB"
+#define TABLEBASE_MAGIC_SIZE 4
+#define TABLEBASE_VERSION 1
+#define TABLEBASE_HEADER_SIZE 32
+#define TABLEBASE_VERSION_OFFSET 4
+#define TABLEBASE_ROWS_OFFSET 8
+#define TABLEBASE_COLUMNS_OFFSET 12
+#define TABLEBASE_KEY_OFFSET 16
+#define TABLEBASE_SLOTS_OFFSET 24
+#define TABLEBASE_SLOT_SIZE 16
+#define TABLEBASE_SLOT_VALUE_OFFSET 8
+#define TABLEBASE_SLOT_MOVE_OFFSET 12
+#define TABLEBASE_MAX_MOVES 24
+
+/* Size of the packed scores and of the packed cell states of a binary save
+ * file, for a board of the given number of cells */
+#define BINARY_SCORES_SIZE(cells) (((cells) + 1) / 2)
+#define BINARY_STATES_SIZE(cells) (((cells) + 3) / 4)
+
+/* The score and the state of the i'th cell of a loaded binary save file */
+#define BINARY_SCORE_AT(i) ((game->loadedScores[(i) / 2] >> (4 * ((i) % 2))) \
+	& 0xF)
+#define BINARY_STATE_AT(i) ((game->loadedStates[(i) / 4] >> (2 * ((i) % 4))) \
+	& 0x3)
+
+/* Takes in the game representation (with the player types and any options
+ * set up), the name of a save file, and the current exit status. Loads,
+ * validates and packs the save file into the game representation (see
+ * file_setup, file_contents_error_handler and pack_board), replaying the
+ * moves of a journal (which is resumed rather than started anew if it is
+ * also the journal asked for, see start_journal, journalResume being where
+ * its last whole move ends). If the save file can't be played, this function
+ * fprints to stderr, frees the game representation and returns the exit
+ * status for the error, returns EXIT_NORMAL otherwise. */
+int load_game(Game* game, char* fileName, ExitCodes* exitStatus);
+
+/* Takes in the number of save files given in batch mode (see --batch), the
+ * save files themselves, and the game representation holding the player
+ * types. Plays every save file (see play_batch_game and list_save_files). */
+void play_batch(int argCount, char** args, Game* settings);
+
+/* Takes in the number of save files given in batch mode, the save files
+ * themselves, and where to store the number of files listed. Lists every
+ * save file, with every file within a save file that is a directory listed
+ * in order of name instead. Returns the malloc'd list of malloc'd names (see
+ * free_save_files), or fprints to stderr and returns NULL (with no files
+ * listed) if memory runs out. */
+char** list_save_files(int argCount, char** args, size_t* fileCount);
+
+/* Takes in a list of save files, its length and capacity, and a malloc'd
+ * file name (or NULL, if it couldn't be allocated). Adds the file name to
+ * the list, growing the list as need be. Returns 1 if the name was added,
+ * otherwise frees it and returns 0, leaving the list as it was. */
+int add_save_file(char*** names, size_t* nameCount, size_t* nameCapacity,
+	char* name);
+
+/* Takes in a list of save files (see list_save_files) and its length, and
+ * frees the list. */
+void free_save_files(char** names, size_t nameCount);
+
+/* Takes in two pointers to file names. Compares the file names as strcmp
+ * would, for qsort. */
+int compare_names(const void* first, const void* second);
+
+/* Takes in the name of a save file, and the game representation holding the
+ * player types. Plays the save file to completion without displaying it,
+ * then prints a single result line: the file name, the winner ('O', 'X', or
+ * 'D' for a draw), the final scores of O and X, the number of moves made,
+ * and the key of the final position (see game->key) in hexadecimal. If the
+ * save file can't be played, the line is instead the file name, "error" and
+ * the exit status for the error. */
+void play_batch_game(char* fileName, Game* settings);
+
+/* Takes in the name of a save file, the game representation holding the
+ * options, the player types, and where to store the result. Plays the save
+ * file to completion in a game representation of its own (with the same
+ * options), without displaying anything, so that any number of games can be
+ * played at once. */
+void play_headless_game(char* fileName, Game* settings, char playerTypeO,
+	char playerTypeX, GameResult* result);
+
+/* Takes in the number of save files given, the save files themselves (see
+ * list_save_files), the player types of player O and of player X, and the
+ * game representation holding the options. Plays every save file with every
+ * pairing of a player type from typesO and a player type from typesX, on as
+ * many threads as asked for (see --threads, by default one per core). The
+ * tasks (numbered file by file, then pairing by pairing) are shared out
+ * evenly between the workers to start with, after which workers with no
+ * tasks left steal them from the others (so the games are all played even
+ * if threads fail to start). Prints a table of the results of every
+ * pairing, and fprints to stderr how long the games took (and what the
+ * searches did, see report_search, report_timed and report_solve). */
+void play_tournament(int argCount, char** args, char* typesO, char* typesX,
+	Game* settings);
+
+/* Takes in a tournament. Frees its workers (any of which may not have been
+ * allocated) and their tallies. */
+void free_workers(Tournament* tournament);
+
+/* Takes in a worker of a tournament. Plays tasks until there are none left,
+ * adding up the results in the worker's tallies. Returns NULL, as a thread
+ * started by pthread_create. */
+void* tournament_worker(void* argument);
+
+/* Takes in a worker of a tournament and where to store the next task. Takes
+ * the newest task from the worker's own deque, or steals the oldest task
+ * from another worker's deque if its own is empty. Returns 1 if a task was
+ * found, or 0 if there are no tasks left. */
+int next_task(Worker* worker, long int* task);
+
+/* Takes in the argument count, the argument values, and the game
+ * representation. Handles the options given before the player types (i.e.
+ * --verbosity=frames, --verbosity=moves, --verbosity=result,
+ * --verbosity=delta, --batch, --tournament, --threads=count, --depth=plies,
+ * --iterations=count, --move-time-ms=milliseconds, --playout=zero,
+ * --playout=one, --solve=cells, --tablebase=fname, --make-tablebase=fname,
+ * --perft=depth, --kernels=name, --bench=passes or --journal=fname), and
+ * returns the number of options handled. In batch mode (which a tournament is
+ * also played in), any number of save files (or directories of them) can be
+ * given, which are all played in the one process, and journals aren't
+ * written. --threads is also the number of threads a type 3 player searches
+ * with (by default one, and always one in a tournament, whose games are
+ * already played in parallel), and if given, of the threads a type 2 player
+ * searches with against the clock (see start_helpers). With --perft, the game
+ * tree of the save file is counted rather than played (see run_perft).
+ * --kernels forces the kernels used (see find_kernels), which --bench times
+ * instead of playing (see run_bench). With --solve, automated players of
+ * types 1 to 3 play exactly (see solve_move) once at most cells cells are
+ * empty (border cells included, see remaining_moves). With --tablebase, they
+ * first look each position up in the tablebase (see tablebase_move), which
+ * --make-tablebase makes from the save file instead of playing (see
+ * make_tablebase). With --move-time-ms, type 2 players search ever deeper
+ * until the time is up (see type_two_move), as type 3 players search until
+ * then. */
+int options_handler(int argc, char** argv, Game* game);
+
 /* Takes in the argument count, the argument values, the current exit status,
  * and the game representation. This function fprints to stderr and returns
  * EXIT_ARGS if an incorrect number of args is found. Otherwise, this function
  * validates the player types that were input when starting the game, fprints
- * to stderr and returns EXIT_PLAYER_TYPE if invalid player type(s) are found,
- * and returns EXIT_NORMAL if the player types entered are both valid. */
+ * to stderr and returns EXIT_PLAYER_TYPE if invalid player type(s) are found
+ * (in a tournament, every character of each is a player type), and returns
+ * EXIT_NORMAL if the player types entered are all valid. */
 int argc_player_types_handler(int argc, char** argv, ExitCodes* exitStatus,
 	Game* game);
 
-/* Takes in the save file, the game representation, the current exit status,
- * the line from the save file that presents the board dimensions, the errors
- * generated by strtol calls to obtain the specific number of rows and
- * columns, and a flag to check for EOF found in invalid places (e.g. when
- * reading in a 3x3 board and EOF is triggered after row 1). If opening the
- * file fails, this function fprints to stderr and returns EXIT_FILE_READ.
- * Otherwise, this function partially validates and sets up the information
- * necessary for the board (i.e. board dimensions, first/current player)
- * and returns EXIT_NORMAL. If invalid contents are found, these are handled
- * in file_contents_error_handler. */
-int file_setup(FILE* gameFile, Game* game, ExitCodes* exitStatus,
-	char** rowsAndColumns, char** rowErrors,
-	char** columnErrors, int* eofFlag);
-
-/* Takes in the game representation, the errors generated by strtol calls to
- * obtain the row and columns from the save file, and the current exit status.
+/* Takes in the game representation and a player type. Returns 1 if the
+ * player type is valid (human players being invalid in batch mode), 0
+ * otherwise. */
+int player_type_valid(Game* game, char type);
+
+/* Takes in the name of a save file and where to load it to. Opens the file
+ * and maps its contents into memory, or if it cannot be mapped (e.g. it is a
+ * pipe) reads the whole file into memory. Returns 1 on success, or 0 if the
+ * file could not be opened, or held in memory. */
+int load_file(char* fileName, LoadedFile* file);
+
+/* Takes in a loaded file and unmaps (or frees) its contents. */
+void close_file(LoadedFile* file);
+
+/* Takes in a loaded file and where to store the length of a line. Returns the
+ * start of the next line of the file (which is not null terminated), and
+ * moves past said line and its new line. Returns NULL if there are no lines
+ * left. */
+const char* next_line(LoadedFile* file, size_t* length);
+
+/* Takes in the start and end of a board dimension from a save file, and where
+ * to store its value. Accepts the same numbers that strtol would convert in
+ * full (i.e. with leading whitespace and an optional sign). Returns 1 if the
+ * dimension is a number, 0 otherwise. */
+int parse_dimension(const char* start, const char* end, long int* value);
+
+/* Takes in the name of the save file, where to load it to, the game
+ * representation, and the current exit status. If opening the file fails,
+ * this function fprints to stderr and returns EXIT_FILE_READ. Otherwise, this
+ * function partially validates and sets up the information necessary for
+ * the board (i.e. board dimensions, first/current player) and returns
+ * EXIT_NORMAL. If invalid contents are found, sentinel values are set, and
+ * these are handled in file_contents_error_handler. */
+int file_setup(char* fileName, LoadedFile* gameFile, Game* game,
+	ExitCodes* exitStatus);
+
+/* Takes in a loaded binary save file (see BINARY_MAGIC), positioned at the
+ * start of the binary board, and the game representation. Sets up the board
+ * dimensions and the current player from the header, points
+ * game->loadedScores and game->loadedStates at the rest of the board, and
+ * moves the file position past the board. If the version is unknown or the
+ * file is cut short, the dimensions are set to sentinel values, which are
+ * handled in file_contents_error_handler. */
+void binary_setup(LoadedFile* gameFile, Game* game);
+
+/* Takes in 4 bytes of a binary save file. Returns the little endian number
+ * they hold. */
+uint32_t read_binary_u32(const unsigned char* in);
+
+/* Takes in 8 bytes of a binary file. Returns the little endian number they
+ * hold. */
+uint64_t read_binary_u64(const unsigned char* in);
+
+/* Takes in where to write to and a number. Writes the number as 4 little
+ * endian bytes, and returns the end of what was written. */
+char* write_binary_u32(char* out, uint32_t value);
+
+/* Takes in where to write to and a number. Writes the number as 8 little
+ * endian bytes, and returns the end of what was written. */
+char* write_binary_u64(char* out, uint64_t value);
+
+/* Takes in the game representation, with a binary save file loaded. Validates
+ * the same rules as for a text save file, and decodes the score of each cell
+ * into game->scores as it goes. Returns 1 if the contents are valid, 0
+ * otherwise. */
+int binary_contents_valid(Game* game);
+
+/* Takes in the game representation and the current exit status.
  * This function validates file contents of specified save file, specifically,
  * it validates the board dimensions, the current player, and board cell
- * values. It also checks that the file dimensions match with the actual board
+ * values, decoding the score of each cell into game->scores as it goes.
+ * It also checks that the file dimensions match with the actual board
  * dimensions. This function returns EXIT_FILE_CONTENTS and fprints to stderr
  * if invalid file contents are found, returns EXIT_NORMAL otherwise. */
-int file_contents_error_handler(Game* game, char* rowErrors,
-	char* columnErrors, ExitCodes* exitStatus);
+int file_contents_error_handler(Game* game, ExitCodes* exitStatus);
 
 /* Takes in loop iterators r and c, the game representation, and counters for
  * the number of zeros in the board interior, and for the number of invalid
@@ -127,168 +879,713 @@ void validate_interior(int r, int c, Game* game, int* interiorZeroCounter,
 void validate_border(int r, int c, Game* game, int* borderZeroCounter,
 	int* invalidCharCounter);
 
-/* Takes in a line of input and counts the number of spaces in said line.
- * Returns the number of spaces. */
-int space_counter(char** input);
-
-/* Takes in a file stream and reads in a line of input, also takes in the
- * maximum length of the line to be read, as well as a flag to check for EOF
- * found in invalid places (e.g. when reading in a 3x3 board and EOF is
- * triggered after row 1). Returns the line read. Note that this line is
- * malloc'd. However, if (valid) EOF is detected then this line is free'd in
- * the function and a sentinel value 'test_EOF' is instead returned. If
- * invalid EOF is detected, update eofFlag to the value of 1 and return the
- * line read as per normal. */
-char* read_line(FILE* file, size_t size, int* eofFlag);
-
-/* Takes in the game representation, the save file, and a flag to check for
- * EOF found in invalid places (e.g. when reading in a 3x3 board and EOF is
- * triggered after row 1). This function initialises the game board by
- * creating an empty game board based on the file contents.
- * These contents should be validated after calling this function. */
-void init_board(Game* game, FILE* gameFile, int* eofFlag);
+/* Takes in the game representation and a row of the loaded board. Returns 1
+ * if every character of the row is exactly what a valid board has there
+ * (i.e. blank corners, zeros on the border, non-zero scores in the interior,
+ * and stones or dots in every cell), checking the row a block at a time with
+ * the kernels. Otherwise returns 0, and the row is then checked a character
+ * at a time (see validate_interior and validate_border). */
+int text_row_valid(Game* game, long int r);
+
+/* Takes in the name of a set of kernels, or NULL for the fastest set the CPU
+ * supports. Returns the set of kernels (see Kernels), or NULL if there is no
+ * such set or the CPU doesn't support it. */
+const Kernels* find_kernels(const char* name);
+
+/* Takes in where to store the number of sets of kernels. Returns every set of
+ * kernels that is built, fastest first (the scalar kernels being last). */
+const Kernels* kernels_list(int* count);
+
+/* Takes in a set of kernels. Returns 1 if the CPU supports its instruction
+ * set, otherwise 0. */
+int kernels_supported(const Kernels* kernels);
+
+/* The kernels of each instruction set (see Kernels). */
+int text_valid_scalar(const char* text, long int length, char low,
+	char high);
+void decode_scores_scalar(const char* row, long int cells, uint8_t* scores);
+void decode_stones_scalar(const char* row, long int cells, BoardWord* cellsO,
+	BoardWord* cellsX);
+int sum_scores_scalar(const uint8_t* scores, const BoardWord* cells,
+	long int words);
+#ifdef KERNELS_X86
+int text_valid_sse2(const char* text, long int length, char low, char high);
+void decode_scores_sse2(const char* row, long int cells, uint8_t* scores);
+void decode_stones_sse2(const char* row, long int cells, BoardWord* cellsO,
+	BoardWord* cellsX);
+int sum_scores_sse2(const uint8_t* scores, const BoardWord* cells,
+	long int words);
+int text_valid_avx2(const char* text, long int length, char low, char high);
+void decode_scores_avx2(const char* row, long int cells, uint8_t* scores);
+void decode_stones_avx2(const char* row, long int cells, BoardWord* cellsO,
+	BoardWord* cellsX);
+int sum_scores_avx2(const uint8_t* scores, const BoardWord* cells,
+	long int words);
+#endif
+
+/* Takes in the input buffer for stdin, and a flag to check for EOF found in
+ * invalid places (e.g. when a valid human move ends in EOF rather than a new
+ * line). Returns the next line of input (within the buffer, so it is only
+ * valid until the next call), reading in the next block of stdin when need
+ * be. Returns NULL if there is nothing but EOF to be read. If the line ends
+ * in EOF, update eofFlag to the value of 1 and return the line as per
+ * normal. */
+char* read_input_line(InputBuffer* input, int* eofFlag);
+
+/* Takes in a human move and where to store the row and column moves. Checks
+ * and converts the move in a single pass: the move must be two numbers (as
+ * strtol would convert in full) separated by exactly one space, and must not
+ * start with a space or a tab. Returns 1 if the move is valid, 0 otherwise. */
+int parse_move(const char* move, long int* row, long int* column);
+
+/* Takes in a cursor into a human move and where to store a number. Converts
+ * the number at the cursor (with leading whitespace other than spaces, and
+ * an optional sign) and moves the cursor past it. Returns 1 on success, or 0
+ * if there is no number at the cursor. */
+int parse_number(const char** cursor, long int* value);
+
+/* Takes in the number of cells in a line of the board (i.e. a row or a
+ * column). Returns the number of words each line takes up in a bitboard,
+ * which is rounded up so that lines are cache friendly (see the comments in
+ * the function). */
+long int line_words(long int cells);
+
+/* Takes in the current size of the arena and the size of a new part of the
+ * arena. Returns the offset of the new part, and increases the size of the
+ * arena to fit the new part (rounded up to a whole cache line). */
+size_t arena_part(size_t* size, size_t partSize);
+
+/* Takes in the game representation, whose dimensions have been set by
+ * file_setup. Allocates the arena holding the whole board (see the Game
+ * representation), sets game->rowWords and game->columnWords, and points each
+ * part of the board into the arena. Returns 1 on success, or 0 if the board
+ * is too large to be allocated. */
+int alloc_arena(Game* game);
+
+/* Takes in the game representation and the loaded save file. This function
+ * initialises the game board by allocating the board arena and finding each
+ * row of the board within the loaded file (binary save files need no more
+ * than the arena). If the dimensions are invalid, no board is allocated
+ * (game->loadedRows remains NULL). These contents should be validated after
+ * calling this function. */
+void init_board(Game* game, LoadedFile* gameFile);
+
+/* Takes in the game representation, whose board has been loaded by
+ * init_board and validated (and its scores decoded) by
+ * file_contents_error_handler. This function builds the rest of the packed
+ * game state (i.e. the occupancy bitmasks and the indexes kept alongside
+ * them, and the key of the position) from the loaded board. */
+void pack_board(Game* game);
+
+/* Takes in a number. Returns the number thoroughly mixed (the finaliser of
+ * SplitMix64), which is used to generate the keys in game->zobrist. */
+uint64_t zobrist_mix(uint64_t value);
+
+/* Takes in the game representation. Returns the key of the board itself
+ * (i.e. its dimensions and the scores of its cells), which never changes
+ * during a game. */
+uint64_t board_key(Game* game);
+
+/* Takes in the game representation. Returns the key of the position (see
+ * game->key), computed from scratch.
+ * NOTE: game->key already holds this key, this is only needed to check it. */
+uint64_t zobrist_hash(Game* game);
+
+/* Takes in the game representation and the row and column of a cell of the
+ * loaded board (text or binary). Returns the stone loaded into said cell
+ * ('O' or 'X'), or '.' if the cell is empty. */
+char loaded_stone(Game* game, long int r, long int c);
+
+/* Takes in the game representation and the row and column of a cell. Returns
+ * the stone occupying said cell ('O' or 'X'), or '.' if the cell is empty.
+ * NOTE: the cell must be within the board and not a corner. */
+char cell_at(Game* game, long int r, long int c);
+
+/* Takes in the game representation, the row and column of a cell, and the
+ * new contents of said cell ('O', 'X', or '.' to empty the cell). Updates the
+ * occupancy bitmasks (in both layouts), the running scores of both players,
+ * the line counters, the empty cell index, and the key accordingly. */
+void set_cell(Game* game, long int r, long int c, char stone);
+
+/* Takes in the game representation, the row of an interior cell that has
+ * been filled or emptied, and the change in the number of empty cells (i.e.
+ * -1 or 1). Updates the empty cell index accordingly. */
+void update_empty_index(Game* game, long int r, int change);
+
+/* Takes in the game representation, a row index, and where to render said
+ * row to. Renders the row of the board, in the save file format and followed
+ * by a new line, and returns the end of the rendered row. */
+char* render_row(Game* game, long int r, char* out);
+
+/* Takes in the game representation and where to render the board to. Renders
+ * the whole game in the binary save file format (see BINARY_MAGIC), and
+ * returns the end of what was rendered. */
+char* render_binary(Game* game, char* out);
+
+/* Takes in the game representation and where to render the board to. Renders
+ * each row of the board (see render_row) and returns the end of the rendered
+ * board. */
+char* render_board(Game* game, char* out);
+
+/* Takes in the game representation and the player who just made the move in
+ * game->rowMove and game->columnMove (or 0 if no move is to be shown).
+ * Renders the frame to be displayed (according to the verbosity) into
+ * game->frame, and writes it to stdout all at once. In delta mode, only the
+ * move is displayed (see render_delta) if it is to be shown, and a full
+ * frame (see render_full_frame) otherwise. */
+void print_frame(Game* game, char player);
+
+/* Takes in the game representation and where to render the frame to. Renders
+ * a full frame for delta mode, being "F", the rows and the columns on one
+ * line, followed by the board (see render_board). Returns the end of the
+ * rendered frame. */
+char* render_full_frame(Game* game, char* out);
+
+/* Takes in the game representation, with the move that was just made in
+ * game->rowMove and game->columnMove, where to render the move to, and the
+ * player who made the move. Renders what the move changed as a single line
+ * for delta mode, being the player, the row and the column, separated by
+ * spaces. A push is followed by a space and the whole pushed line afterwards,
+ * one character ('O', 'X' or '.') per cell: the column from top to bottom if
+ * the move was in the top or bottom row, otherwise the row from left to
+ * right. Returns the end of the rendered line. */
+char* render_delta(Game* game, char* out, char player);
 
 /* Takes in the game representation and checks if the game board interior is
- * full. If so, returns EXIT_FULL_BOARD, otherwise returns EXIT_NORMAL. */
+ * full (i.e. it has no empty cells). If so, returns EXIT_FULL_BOARD,
+ * otherwise returns EXIT_NORMAL. */
 int check_board_full(Game* game);
 
-/* Takes in the game representation, the current exit status, the line from
- * the save file that showed the dimensions of the board, the save file
- * itself, and a flag to check for EOF found in invalid places (e.g. when
- * processing a valid human move that ends in EOF). This function forms as the
- * entry point for the game. It handles EOF on stdin when input required, the
- * results of all types of game moves (i.e. type 0, type 1, and human), and
- * all free's and file closing in case of an abrupt termination of the game */
-void play_game(Game* game, ExitCodes* exitStatus, char* rowsAndColumns,
-	FILE* gameFile, int* eofFlag);
-
-/* Takes in the human move made, the strtol errors generated by calls to 
- * obtain the specific row and column moves, the game representation, the
- * current exit status, and a flag to check for EOF found in invalid places
- * (e.g. when processing a valid human move that ends in EOF). Entry point for
- * handling the execution of Type 0, Type 1, and Human game moves, as well as
- * saving. */
-void game_move(char** move, char** rowMoveErrors, char** columnMoveErrors,
-	Game* game, ExitCodes* exitStatus, int* eofFlag);
-
-/* Takes in the strtol errors generated by calls to obtain the specific row
- * and column moves, and the game representation. Executes the move calculated
- * by game_move. */
+/* Takes in the game representation, the current exit status, and a flag to
+ * check for EOF found in invalid places (e.g. when processing a valid human
+ * move that ends in EOF). This function forms as the entry point for the
+ * game. It handles EOF on stdin when input required, the results of all
+ * types of game moves (i.e. type 0, type 1, and human), and all free's in
+ * case of an abrupt termination of the game */
+void play_game(Game* game, ExitCodes* exitStatus, int* eofFlag);
+
+/* Takes in the errors generated by obtaining the specific row and column
+ * moves, the game representation, the current exit status, and a flag to
+ * check for EOF found in invalid places (e.g. when processing a valid human
+ * move that ends in EOF). Entry point for handling the execution of Type 0,
+ * Type 1, and Human game moves, as well as saving. Sets the exit status to
+ * EXIT_EOF if stdin ran out when input was required. */
+void game_move(char** rowMoveErrors, char** columnMoveErrors, Game* game,
+	ExitCodes* exitStatus, int* eofFlag);
+
+/* Takes in the errors generated by obtaining the specific row and column
+ * moves, and the game representation. Executes the move calculated by
+ * game_move, if it is legal (see move_legal), and then records and displays
+ * it (see finish_move). */
 void play_move(char* rowMoveErrors, char* columnMoveErrors, Game* game);
 
-/* Takes in the human move (for error handling), the strtol errors generated
- * by calls to obtain the specific row and column moves (also for error
- * handling), and the game representation. Handles Type 0 moves. Does NOT
- * print the new move. */
-void type_zero_move(char** move, char** rowMoveErrors,
-	char** columnMoveErrors, Game* game);
-
-/* Takes in the game representation, the current opponent, the human move (for
- * error handling), and the strtol errors generated by calls to obtain the
- * specific row and column moves (also for error handling). Entry point for
- * all type one moves. Selects the appropriate type one move to play.
- * NOTE does not execute said move. */
-void type_one_move(Game* game, char opponent, char** move,
-	char** rowMoveErrors, char** columnMoveErrors);
-
-/* Takes in the game representation, the current opponent, the human move (for
- * error handling), and the strtol errors generated by calls to obtain the
- * specific row and column moves (also for error handling). Checks if there
- * exists a move that pushes cells down such that the opponent's score is
- * lowered. Returns 1 if such a move is found, returns 0 otherwise.
- * NOTE: does not execute said move even if such a move is found. */
-int type_one_push_down(Game* game, char opponent, char** move,
-	char** rowMoveErrors, char** columnMoveErrors);
-
-/* Takes in the game representation, the current opponent, the human move (for
- * error handling), and the strtol errors generated by calls to obtain the
- * specific row and column moves (also for error handling). Checks if there
- * exists a move that pushes cells left such that the opponent's score is
- * lowered. Returns 1 if such a move is found, returns 0 otherwise.
- * NOTE: does not execute said move even if such a move is found. */
-int type_one_push_left(Game* game, char opponent, char** move,
-	char** rowMoveErrors, char** columnMoveErrors);
-
-/* Takes in the game representation, the current opponent, the human move (for
- * error handling), and the strtol errors generated by calls to obtain the
- * specific row and column moves (also for error handling). Checks if there
- * exists a move that pushes cells up such that the opponent's score is
- * lowered. Returns 1 if such a move is found, returns 0 otherwise.
- * NOTE: does not execute said move even if such a move is found. */
-int type_one_push_up(Game* game, char opponent, char** move,
-	char** rowMoveErrors, char** columnMoveErrors);
-
-/* Takes in the game representation, the current opponent, the human move (for
- * error handling), and the strtol errors generated by calls to obtain the
- * specific row and column moves (also for error handling). Checks if there
- * exists a move that pushes cells right such that the opponent's score is
- * lowered. Returns 1 if such a move is found, returns 0 otherwise.
+/* Takes in the game representation, a legal move of the current player, and
+ * where to record how to undo the move. Makes the move (updating the packed
+ * state, the running totals and the key) and passes the turn to the other
+ * player, without displaying, journalling or counting the move. */
+void make_move(Game* game, const Move* move, Undo* undo);
+
+/* Takes in the game representation and how to undo the last move made (see
+ * make_move). Restores the position from before said move, in time
+ * proportional to the length of the line the move pushed (if any). */
+void unmake_move(Game* game, const Undo* undo);
+
+/* Takes in the game representation and where to store the moves (which
+ * must have room for MOVE_CAPACITY moves). Stores every legal move of the
+ * current player, in board order (top to bottom, left to right), in a single
+ * pass over the board and without allocating. Returns the number of moves
+ * stored, which is 0 once the game is over. */
+int generate_moves(Game* game, Move* moves);
+
+/* Takes in the game representation and the row and column of a move.
+ * Returns 1 if the current player can make said move, 0 otherwise. */
+int move_legal(Game* game, long int r, long int c);
+
+/* Takes in the game representation, a push direction, and the row and
+ * column of the border cell the push is made from. Returns 1 if the push is
+ * legal (i.e. the border cell is empty, there is a stone next to it to push,
+ * and there is an empty cell in the line to push said stone into), 0
+ * otherwise. */
+int push_legal(Game* game, PushDirection push, long int r, long int c);
+
+/* Takes in the game representation. Counts the leaf positions of the game
+ * tree to each depth from 1 to --perft (see perft), printing each count and
+ * fprinting to stderr how fast they were counted. */
+void run_perft(Game* game);
+
+/* Takes in the game representation, the depth to count to, and the number of
+ * moves made since the count started. Returns the number of leaf positions
+ * of the game tree to said depth (each move at the last depth being counted
+ * rather than made). Debug builds also check the moves generated for every
+ * position against move_legal. */
+long int perft(Game* game, int depth, int ply);
+
+/* Takes in the game representation (whose board has been loaded). Runs every
+ * set of kernels the CPU supports over the rows of the board (as they would
+ * be saved) --bench times, fprinting to stderr how fast each set was, and
+ * whether its results differ from the scalar kernels. */
+void run_bench(Game* game);
+
+/* Takes in the game representation, a set of kernels, the board's rows as
+ * they would be saved, and room for one row's scores and for one row's
+ * worth of words for each player. Runs the kernels over every row once.
+ * Returns a checksum of the results. */
+long int bench_pass(Game* game, const Kernels* kernels, const char* text,
+	uint8_t* scores, BoardWord* cells);
+
+/* Takes in the errors generated by obtaining the specific row and column
+ * moves (for error handling), and the game representation. Handles Type 0
+ * moves. Does NOT print the new move. */
+void type_zero_move(char** rowMoveErrors, char** columnMoveErrors,
+	Game* game);
+
+/* Takes in the game representation, the current opponent, and the errors
+ * generated by obtaining the specific row and column moves (for error
+ * handling). Entry point for all type one moves. Selects the appropriate type
+ * one move to play (see type_one_sweep). NOTE does not execute said move. */
+void type_one_move(Game* game, char opponent, char** rowMoveErrors,
+	char** columnMoveErrors);
+
+/* Takes in the game representation and the current opponent. Sweeps the
+ * interior once, row by row and a word at a time, keeping running sums of the
+ * opponent's score (and of that score once pushed) along each row and column
+ * that a push could be made along, and the highest value empty cell found so
+ * far. Only the opponent's stones and the empty cells are visited. Each kind
+ * of type one move is then taken in the order specified in the spec: a push
+ * down that lowers the opponent's score (checking columns left to right), a
+ * push left (rows top to bottom), a push up (columns right to left), a push
+ * right (rows bottom to top), and otherwise the highest value empty cell (the
+ * first one if the scores are tied). Returns the move found. */
+Move type_one_sweep(Game* game, char opponent);
+
+/* Takes in the game representation, a push direction, the border cell pushed
+ * from, and the sums of the line it pushes (see type_one_sweep). Returns 1 if
+ * the push is legal, the border cell at the other end of the line is empty,
+ * and the push lowers the opponent's score, otherwise returns 0. */
+int type_one_push_lowers(Game* game, PushDirection push, long int r,
+	long int c, LineSums sums);
+
+/* Takes in the game representation, the current opponent, and the errors
+ * generated by obtaining the specific row and column moves (for error
+ * handling). Only compiled in DEBUG, this selects the type one move by
+ * evaluating each legal move in turn (see generate_moves), which
+ * type_one_move checks the sweep against. NOTE does not execute said move. */
+void type_one_reference(Game* game, char opponent, char** rowMoveErrors,
+	char** columnMoveErrors);
+
+/* Takes in the game representation, the current opponent, the number of
+ * legal moves in game->moves, a push direction, and the errors generated by
+ * obtaining the specific row and column moves (for error handling). Checks if
+ * there exists a move that pushes cells in said direction such that the
+ * opponent's score is lowered, checking columns left to right for pushes
+ * down, rows top to bottom for pushes left, columns right to left for pushes
+ * up, and rows bottom to top for pushes right. Returns 1 if such a move is
+ * found, returns 0 otherwise. Only compiled in DEBUG (see
+ * type_one_reference).
  * NOTE: does not execute said move even if such a move is found. */
-int type_one_push_right(Game* game, char opponent, char** move,
-	char** rowMoveErrors, char** columnMoveErrors);
-
-/* Takes in the game representation, the human move (for error handling), and
- * the strtol errors generated by calls to obtain the specific row and column
- * moves (also for error handling). After checking the current scores of both
- * players, this function searches the board for the highest value cell. If
- * the scores are currently tied, only the first highest value cell that is
- * found is selected. NOTE: does not execute the move that is found. */
-void type_one_highest_cell(Game* game, char** move, char** rowMoveErrors,
+int type_one_push(Game* game, char opponent, int moveCount,
+	PushDirection direction, char** rowMoveErrors,
+	char** columnMoveErrors);
+
+/* Takes in the game representation, the number of legal moves in
+ * game->moves, and the errors generated by obtaining the specific row and
+ * column moves (for error handling). After checking the current scores of
+ * both players, this function searches the empty cells for the highest value
+ * cell. If the scores are currently tied, only the first highest value cell
+ * that is found is selected. Only compiled in DEBUG (see type_one_reference).
+ * NOTE: does not execute the move that is found. */
+void type_one_highest_cell(Game* game, int moveCount, char** rowMoveErrors,
 	char** columnMoveErrors);
 
-/* Takes in the human move, the game representation, the strtol errors
- * generated by calls to obtain the specific row and column moves, and a flag
- * to check for EOF found in invalid places (e.g. when processing a valid
- * human move that ends in EOF). Ensures no leading or trailing spaces, no
- * invalid chars, no leading or trailing tabs, no empty moves, also ensure
- * move isn't save move, as saves should allow spaces in save file name. Also
- * forms as entry point for saving, and processes the specific row and column
- * moves. */
-void human_move(char** move, Game* game, char** rowMoveErrors,
+/* Takes in the errors generated by obtaining the specific row and column
+ * moves (for error handling), and the game representation. Handles Type 2
+ * moves, which search every move (placements and pushes) to a fixed depth
+ * (see negamax) and take the best one. With --move-time-ms, searches to
+ * depth 1, 2, 3 and so on instead (up to --depth, if given, or the end of
+ * the game), stopping the search in progress once the time is up and taking
+ * the best move of the deepest search completed (or, if the time is up
+ * during the first search, the best move it had found). With --threads as
+ * well, helper threads search the same position meanwhile (see
+ * start_helpers); searches to a fixed depth are never helped, so that
+ * their results don't depend on the number of threads.
+ * fprints the depth reached to stderr (with --verbosity=moves only), and
+ * adds it and the time taken (including starting and stopping the helpers)
+ * to what report_timed reports. Does NOT print the new move. */
+void type_two_move(char** rowMoveErrors, char** columnMoveErrors,
+	Game* game);
+
+/* Takes in the game representation. Sets --threads - 1 helpers searching
+ * the position (see helper_search) on copies of the game, which share its
+ * transposition table (see SharedTable) and are told to stop through a
+ * shared flag. The helpers, their copies and the table are made on the
+ * first call (as many helpers as threads can be started for), and on later
+ * calls each copy is brought up to the game's position with a copy of its
+ * arena before the helpers are woken. Returns 1, or 0 if there wasn't the
+ * memory for the table or the helpers (the game then searching alone). */
+int start_helpers(Game* game);
+
+/* Takes in the game representation. Tells its helpers to stop and waits for
+ * them to, adding the nodes they searched to the timed nodes. */
+void stop_helpers(Game* game);
+
+/* Takes in the game representation. Tells its helpers to exit, waits for
+ * them, and frees them and their copies of the game. */
+void free_helpers(Game* game);
+
+/* Takes in a helper. Waits to be woken for each move (see start_helpers),
+ * searches it (see helper_search), and tells the game once done, until told
+ * to exit. Returns NULL, as a thread started by pthread_create. */
+void* helper_thread(void* argument);
+
+/* Takes in a helper. Searches the position ever deeper from the helper's
+ * first depth, to the end of the game or until told to stop, leaving what it
+ * finds in the shared table for the other threads. Helpers start at
+ * different depths so that they mostly search different positions at once.
+ */
+void helper_search(Helper* helper);
+
+/* Takes in the game representation. Searches the position ever deeper until
+ * the move time runs out, for type_two_move, setting the row and column move
+ * to the best move of the deepest search completed. Returns the depth of that
+ * search (0 if none was completed), adding the nodes searched to the timed
+ * nodes. */
+int timed_search(Game* game);
+
+/* Takes in the game representation and a number of plies. Allocates the
+ * transposition table (if it hasn't been already) and room for the moves of
+ * a search to said depth (if there isn't room already). */
+void search_tables(Game* game, int plies);
+
+/* Takes in the errors generated by obtaining the specific row and column
+ * moves (for error handling), and the game representation. Used by
+ * automated players of types 1 to 3 once few enough cells are empty (see
+ * --solve). Every move adds a stone to the board, so the game ends within
+ * remaining_moves moves, and searching that deep (see negamax) finds the
+ * move with the best final score difference for the player to move, with
+ * the transposition table remembering each position solved. The time taken
+ * hence depends on how many cells are empty (border cells included). Adds
+ * the solve to the nodes and time reported by report_solve. Does NOT print
+ * the new move. */
+void solve_move(char** rowMoveErrors, char** columnMoveErrors, Game* game);
+
+/* Takes in the game representation. Returns the number of cells (other than
+ * the corners) that are empty, which is the most moves the game can last, as
+ * every move adds a stone to one of them. */
+int remaining_moves(Game* game);
+
+/* Takes in the game representation (whose board has been loaded). Makes a
+ * tablebase of every position reachable from the save file, solving each
+ * one exactly (see tablebase_solve), and writes it to the file named by
+ * --make-tablebase (see TABLEBASE_MAGIC). fprints to stderr how many
+ * positions were solved and how fast, and returns EXIT_NORMAL. Otherwise
+ * fprints to stderr that the board is too big (see TABLEBASE_MAX_MOVES),
+ * that there wasn't the memory for it, or that the tablebase couldn't be
+ * written, and returns EXIT_TABLEBASE. */
+int make_tablebase(Game* game);
+
+/* Takes in the game representation, the positions solved so far, and the
+ * number of moves made since the tablebase was started. Searches every move
+ * of the position (without pruning, so that every position reached is
+ * solved exactly), adding the position to the tablebase unless the board is
+ * full. Returns the final score difference for the player to move. */
+int tablebase_solve(Game* game, Tablebase* tablebase, int ply);
+
+/* Takes in the slots of a tablebase being made, the number of slots, and
+ * the key of a position. Returns the slot holding the position, or the empty
+ * slot it belongs in. */
+TablebaseSlot* tablebase_slot(TablebaseSlot* slots, uint64_t slotCount,
+	uint64_t key);
+
+/* Takes in the positions solved so far, and the key, value and best move of
+ * another position. Adds the position to the tablebase, doubling the number
+ * of slots first if more than half would be used (setting failed instead if
+ * they can't be). */
+void tablebase_store(Tablebase* tablebase, uint64_t key, int value,
+	uint32_t move);
+
+/* Takes in the game representation (whose board has been packed). Maps the
+ * tablebase named by --tablebase into memory, keeping it if it was made for
+ * this board. fprints to stderr if the file can't be loaded or isn't a
+ * tablebase, in which case the game is played without it. */
+void open_tablebase(Game* game);
+
+/* Takes in the game representation. Looks the position up in the tablebase
+ * (see TABLEBASE_MAGIC), if there is one. Returns 1 and sets the row and
+ * column move to the best move if the position is found (and the move is
+ * legal), otherwise returns 0. */
+int tablebase_move(Game* game);
+
+/* Takes in the game representation, the depth to search to, the alpha and
+ * beta bounds, the number of moves made since the search started, and where
+ * to store the best move. Searches the position with negamax and alpha-beta
+ * pruning, reusing (and filling in) the transposition table, and counting
+ * the positions searched in game->searchNodes. Positions are valued as the
+ * score difference for the player to move, which is the final result once
+ * the board is full. If game->deadlineSet (or game->stopFlag), checks the
+ * clock (or the flag) every SEARCH_CHECK_NODES positions (below the root),
+ * and once the deadline passes (or the flag is set) sets
+ * game->searchStopped and unwinds without storing anything, the
+ * value returned then being meaningless and the best move being the best of
+ * the moves searched in full. Returns the value of the position. */
+int negamax(Game* game, int depth, int alpha, int beta, int ply,
+	long int* bestRow, long int* bestColumn);
+
+/* Takes in the game representation, the key of a position, and where to
+ * store what the transposition table holds for it. Looks the position up in
+ * the shared table if there is one (see SharedTable), otherwise in the
+ * game's own. Returns 1 if the position was found, otherwise 0. */
+int table_probe(Game* game, uint64_t key, TableEntry* entry);
+
+/* Takes in the game representation and what a search found for a position.
+ * Stores it in the game's own transposition table, replacing whatever the
+ * entry held, or in the shared table (see SharedTable), unless the entry
+ * there is for another position, stored during this move, and deeper. */
+void table_store(Game* game, const TableEntry* entry);
+
+/* Takes in the game representation, a legal move, and the depth, bounds and
+ * ply to search the position after the move with (see negamax). Makes the
+ * move, searches it, and then unmakes the move. Returns the value of the
+ * position after the move, for the player who then moves. */
+int search_move(Game* game, const Move* move, int depth, int alpha, int beta,
+	int ply);
+
+/* Takes in the game representation, where to store the moves (see
+ * generate_moves), and the row and column of the move to try first (-1 if
+ * none). Stores every legal move of the current player, in the order a
+ * search should try them. Returns the number of moves stored. */
+int order_moves(Game* game, Move* moves, long int firstRow,
+	long int firstColumn);
+
+/* Takes in the row errors, column errors and the game representation.
+ * Searches for a type 3 player's move with Monte Carlo tree search (see
+ * mcts_search), on one thread or as many as asked for (see --threads). Each
+ * thread searches a tree of its own, and the move played through the most
+ * over every tree is taken (or, if no thread could be started for lack of
+ * memory, the move a type 1 player would make). Does NOT print the new
+ * move. */
+void type_three_move(char** rowMoveErrors, char** columnMoveErrors,
+	Game* game);
+
+/* Takes in the game representation, one of its searchers, and the number of
+ * the searcher (which its random numbers are seeded with). Makes the
+ * searcher's copy of the game if it has none yet, and starts its tree at the
+ * game's position with the root expanded. Returns 1, or 0 if there wasn't
+ * the memory for the copy or the tree. */
+int start_searcher(Game* game, Searcher* searcher, int t);
+
+/* Takes in a searcher of a type 3 player's move. Runs iterations of UCT
+ * until the searcher's budget runs out, each of which selects a path down
+ * the tree (see mcts_select), expands the node at the end of it (see
+ * mcts_expand), plays the rest of the game out with the default policy (see
+ * playout_move), and adds the result to every node on the path. Returns
+ * NULL, as a thread started by pthread_create. */
+void* mcts_search(void* argument);
+
+/* Takes in a searcher. Sets its copy of the game back to the position being
+ * searched. */
+void restore_root(Searcher* searcher);
+
+/* Takes in a searcher and the index of an expanded node with children.
+ * Returns the index of the child with the highest upper confidence bound
+ * (UCB1), or of its first child that hasn't been visited yet. */
+int32_t mcts_select(Searcher* searcher, int32_t index);
+
+/* Takes in a searcher and the index of a node, whose position the
+ * searcher's game is in. Adds a child to the node for each legal move (in
+ * the order of order_moves, which is hence the order unvisited children are
+ * tried in). Returns 1, or 0 (leaving the node without children) if there
+ * wasn't the memory for them. */
+int mcts_expand(Searcher* searcher, int32_t index);
+
+/* Takes in a searcher. Plays a move of the default policy (see --playout)
+ * for the current player of the searcher's game, or (one move in
+ * MCTS_RANDOM_MOVES) a placement in a random empty cell. */
+void playout_move(Searcher* searcher);
+
+/* Takes in the state of a random number generator. Returns the next random
+ * number (of xorshift64*). */
+uint64_t next_random(uint64_t* state);
+
+/* Takes in the game representation, the index of an empty interior cell
+ * (counting from 0, top to bottom then left to right), and the row errors and
+ * column errors. Sets the move to said cell. */
+void empty_cell_move(Game* game, long int index, char** rowMoveErrors,
+	char** columnMoveErrors);
+
+/* Takes in the game representation. Returns a copy of the game (with an
+ * arena of its own, and no stats or searchers) that moves can be made on
+ * without displaying them, journalling them, or affecting the game, or NULL
+ * if there wasn't the memory for it. The copy is freed with
+ * game_free_memory. */
+Game* copy_game(Game* game);
+
+/* Takes in what is being reported on, and the iterations the searches of
+ * type 3 players ran in total and how many seconds they took. fprints the
+ * iterations per second to stderr, if there were any iterations. */
+void report_search(const char* name, long int iterations, double seconds);
+
+/* Takes in the stats to add to and the stats of another game. Adds the
+ * counts and times of the game to the total, keeping the slowest moves of
+ * either. */
+void add_stats(Stats* total, const Stats* stats);
+
+/* Takes in what is being reported on, how many moves type 2 players searched
+ * against the clock, the total of the depths they completed, the nodes
+ * searched, and how many seconds they took in total and at most. fprints
+ * the mean depth, the nodes per second and the slowest move to stderr, if
+ * there were any such moves. */
+void report_timed(const char* name, long int moves, long int depths,
+	long int nodes, double seconds, double slowest);
+
+/* Takes in where to store a deadline and a number of milliseconds. Sets the
+ * deadline to that long from now (by the monotonic clock). */
+void set_deadline(struct timespec* deadline, long int milliseconds);
+
+/* Takes in a deadline. Returns 1 if the monotonic clock has reached it,
+ * otherwise 0. */
+int deadline_passed(const struct timespec* deadline);
+
+/* Takes in what is being reported on, how many moves were solved exactly
+ * (see solve_move), the nodes searched solving them, and how many seconds
+ * they took in total and at most. fprints the nodes per second and the
+ * slowest move to stderr, if any moves were solved. */
+void report_solve(const char* name, long int moves, long int nodes,
+	double seconds, double slowest);
+
+/* Takes in the human move, the game representation, the errors generated by
+ * obtaining the specific row and column moves, and a flag to check for EOF
+ * found in invalid places (e.g. when processing a valid human move that ends
+ * in EOF). Forms as entry point for saving (moves starting with an s, as
+ * saves should allow spaces in save file name), displays a full frame for
+ * "f" in delta mode, and otherwise validates and processes the specific row
+ * and column moves (see parse_move). */
+void human_move(char* move, Game* game, char** rowMoveErrors,
 	char** columnMoveErrors, int* eofFlag);
 
 /* Takes in score values for players O and X, and the game representation.
- * Calculates the current scores for players O and X. */
+ * Calculates the current scores for players O and X from the whole board
+ * (a row at a time, see Kernels).
+ * NOTE: game->scoreO and game->scoreX already hold these scores, this is only
+ * needed to check them. */
 void current_score_calc(int* scoreO, int* scoreX, Game* game);
 
-/* Takes in the game representation and selects the appropriate pushing cells
- * move to play, and ensures pushing move rules are met. */
-void push_move(Game* game);
-
-/* Takes in the game representation, a counter for the number of empty cells
- * in a given column, and an iterator to iterate through a column. This
- * function handles pushing cells up, and ensures pushing move rules are
- * met. */
-void push_up(Game* game, int emptyCellCounter, int r);
-
-/* Takes in the game representation, a counter for the number of empty cells
- * in a given column, and an iterator to iterate through a column. This
- * function handles pushing cells down, and ensures pushing move rules are
- * met. */
-void push_down(Game* game, int emptyCellCounter, int r);
-
-/* Takes in the game representation, a counter for the number of empty cells
- * in a given row, and an iterator to iterate through a row. This function
- * handles pushing cells left, and ensures pushing move rules are met. */
-void push_left(Game* game, int emptyCellCounter, int c);
-
-/* Takes in the game representation, a counter for the number of empty cells
- * in a given row, and an iterator to iterate through a row. This function
- * handles pushing cells right, and ensures pushing move rules are met. */
-void push_right(Game* game, int emptyCellCounter, int c);
-
-/* Takes in the game representation, the strtol errors generated by calls to
- * obtain row and column moves (for error handling), and the overall move
- * (also for error handling). This function saves the game by writing to a
- * save file with the given information from the game representation. */
-void save_game(char** rowMoveErrors, char** columnMoveErrors, char** move,
-	Game* game);
+#ifdef DEBUG
+/* Takes in the game representation and checks that the running scores, the
+ * column layout, the line counters, the empty cell index and the key match
+ * those calculated from the whole board. If not,
+ * this function fprints both to stderr and aborts. Only present in debug
+ * builds (i.e. make debug), where it is called after every move made or
+ * unmade. */
+void verify_state(Game* game);
+#endif
+
+/* Takes in the game representation and how to undo the move being made (see
+ * make_move), which holds the move. Selects the appropriate pushing cells
+ * move to make. NOTE: the move must be a legal push (see push_legal). */
+void push_move(Game* game, Undo* undo);
+
+/* Takes in the game representation and how to undo the move being made.
+ * This function handles pushing cells up, recording the cells that moved.
+ * NOTE: the move must be a legal push (see push_legal). */
+void push_up(Game* game, Undo* undo);
+
+/* Takes in the game representation and how to undo the move being made.
+ * This function handles pushing cells down, recording the cells that moved.
+ * NOTE: the move must be a legal push (see push_legal). */
+void push_down(Game* game, Undo* undo);
+
+/* Takes in the game representation and how to undo the move being made.
+ * This function handles pushing cells left, recording the cells that moved.
+ * NOTE: the move must be a legal push (see push_legal). */
+void push_left(Game* game, Undo* undo);
+
+/* Takes in the game representation and how to undo the move being made.
+ * This function handles pushing cells right, recording the cells that
+ * moved. NOTE: the move must be a legal push (see push_legal). */
+void push_right(Game* game, Undo* undo);
+
+/* Takes in the words of a line of both players' bitboards (in the layout
+ * where the line is a run of bits), the cell to start searching from, and the
+ * direction to search in (1 to search forwards, -1 to search backwards).
+ * Returns the first empty cell found. NOTE: there must be an empty cell
+ * within the line in the direction searched. */
+long int find_empty(BoardWord* lineO, BoardWord* lineX, long int from,
+	int step);
+
+/* Takes in the game representation, whether the line pushed is a column (1)
+ * or a row (0), the index of said line, the lowest and highest cells of the
+ * line that move, the direction of the push (1 if the stones move to higher
+ * cells, -1 if they move to lower cells), and the stone to put in the pushed
+ * cell (the cell at the start of the push). Shifts the stones of the line a
+ * word at a time, puts the stone in the pushed cell, and updates the rest of
+ * the game representation. When pushing, the stone is the current player's
+ * and the cell at the far end of the push must be empty (and is filled).
+ * When undoing a push (see unmake_move), the line is pushed back the other
+ * way with a stone of '.', which empties the pushed cell. */
+void push_line(Game* game, int isColumn, long int line, long int low,
+	long int high, int step, char stone);
+
+/* Takes in the game representation, whether the line pushed is a column (1)
+ * or a row (0), the index of said line, the index of a word of the line, and
+ * which bits of said word changed for each player during a push. Updates the
+ * running scores, the key, and the other layout of the board for each cell
+ * that changed. */
+void mirror_changes(Game* game, int isColumn, long int line, long int w,
+	BoardWord changedO, BoardWord changedX);
+
+/* Takes in the game representation and the player who just made the move in
+ * game->rowMove and game->columnMove (see make_move). Counts the move,
+ * records it in the journal (if there is one), and displays the move and the
+ * board (see print_frame). */
+void finish_move(Game* game, char player);
+
+/* Takes in the game representation, with the move that is about to be made
+ * (or was just made) in game->rowMove and game->columnMove. Returns the
+ * direction the move pushes in, or PUSH_NONE if the move is in the
+ * interior. */
+PushDirection push_direction(Game* game);
+
+/* Takes in the game representation. If a journal was asked for (see
+ * --journal), creates the journal and writes the current position to it as
+ * the initial position, or if the game was loaded from that very journal,
+ * resumes it (dropping any move cut short at its end) so the moves made are
+ * added to those replayed. fprints to stderr if the journal can't be
+ * created or written, and the game is then played without one. */
+void start_journal(Game* game);
+
+/* Takes in the game representation, with the move that was just made in
+ * game->rowMove and game->columnMove, and the player who made it. Appends
+ * the move to the journal, and flushes it. fprints to stderr if the move
+ * can't be written, and the rest of the game isn't journalled. */
+void journal_move(Game* game, char player);
+
+/* Takes in the game representation. fprints to stderr that the journal
+ * failed, and closes it. */
+void journal_failed(Game* game);
+
+/* Takes in the names of two files. Returns 1 if both exist and are the same
+ * file (e.g. through different paths), otherwise 0. */
+int same_file(const char* first, const char* second);
+
+/* Takes in the game representation, with its initial position packed, the
+ * loaded save file, and the current exit status. If the save file is a
+ * journal, replays each of its moves. This function returns
+ * EXIT_FILE_CONTENTS and fprints to stderr if a move can't be replayed (i.e.
+ * it is illegal, or not as recorded), returns EXIT_NORMAL otherwise. */
+int replay_journal(Game* game, LoadedFile* gameFile, ExitCodes* exitStatus);
+
+/* Takes in the name of the save file (which may be empty, in which case
+ * nothing is saved) and the game representation. This function saves the
+ * game by writing to a save file with the given information from the game
+ * representation, in the binary format if the file name ends in
+ * BINARY_EXTENSION. */
+void save_game(char* fileName, Game* game);
 
-/* Takes in the game representation, the line from the save file that shows
- * the board dimensions, and the save file itself. Handles calculating and
- * displaying the game winner(s), and handles all free's and file closing. */
-void game_over(Game* game, char* rowsAndColumns, FILE* gameFile);
+/* Takes in the game representation. Handles calculating and displaying the
+ * game winner(s), and handles all free's. */
+void game_over(Game* game);
 
-/* Takes in the game representation and frees the board contents, the board
- * itself, and the game representation itself (as these were malloc'd). */
+/* Takes in the game representation and frees the board arena and the game
+ * representation itself (as these were malloc'd), closing the journal if
+ * there is one and freeing the input buffer and any search tables. */
 void game_free_memory(Game* game);
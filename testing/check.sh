@@ -0,0 +1,190 @@
+#!/bin/sh
+# Checks a push2310 built with -DDEBUG (push2310-debug, see make check)
+# against the boards in this directory and a set of seeded random boards.
+# Prints each failure, and exits with status 1 if there were any.
+#
+# Usage: check.sh push2310-debug
+
+program=$1
+boards=$(dirname "$0")
+if [ ! -x "$program" ]; then
+    echo "Usage: check.sh push2310-debug" >&2
+    exit 1
+fi
+scratch=$(mktemp -d)
+trap 'rm -rf "$scratch"' EXIT
+failures=0
+
+fail() {
+    echo "FAIL: $*"
+    failures=$((failures + 1))
+}
+
+# Writes a random board (of 3 to 12 rows and columns unless the number of
+# columns is given, with stones on the border as well as the interior) from
+# the given seed to stdout
+random_board() {
+    awk -v seed="$1" -v width="${2:-0}" 'BEGIN {
+        srand(seed)
+        rows = 3 + int(rand() * 10)
+        columns = width ? width : 3 + int(rand() * 10)
+        print rows, columns
+        print (rand() < 0.5) ? "O" : "X"
+        for (r = 0; r < rows; r++) {
+            line = ""
+            for (c = 0; c < columns; c++) {
+                edge = (r == 0 || r == rows - 1) + (c == 0 || c == columns - 1)
+                if (edge == 2) {
+                    line = line "  "
+                    continue
+                }
+                x = rand()
+                state = (x < 0.6) ? "." : (x < 0.8) ? "O" : "X"
+                line = line (edge ? 0 : 1 + int(rand() * 9)) state
+            }
+            print line
+        }
+    }'
+}
+
+mkdir "$scratch/random"
+for seed in $(seq 1 100); do
+    random_board "$seed" > "$scratch/random/$seed"
+done
+set -- "$boards"/board* "$boards"/specboard* "$boards"/dotboard \
+        "$boards"/hboard "$boards"/xboard "$scratch"/random/*
+
+# Type 1 moves - the debug build checks every move type_one_sweep chooses
+# against type_one_reference, and aborts if they differ
+for types in "1 1" "1 0" "0 1"; do
+    if ! "$program" --batch $types "$@" > "$scratch/out" 2>&1; then
+        fail "type 1 sweep ($types):"
+        grep "Type one sweep" "$scratch/out"
+    fi
+done
+
+# Perft - every count of perft.counts (board, depth, nodes), each board being
+# counted once to its deepest depth listed
+grep -v "^#" "$boards/perft.counts" | awk '$2 > deepest[$1] {
+    deepest[$1] = $2
+} END {
+    for (board in deepest) {
+        print board, deepest[board]
+    }
+}' | while read -r board depth; do
+    "$program" --perft="$depth" 0 0 "$boards/$board" 2> /dev/null |
+            awk -v board="$board" '{ print board, $0 }'
+done | sort > "$scratch/perft"
+grep -v "^#" "$boards/perft.counts" | sort > "$scratch/expected"
+if ! cmp -s "$scratch/perft" "$scratch/expected"; then
+    fail "perft counts:"
+    diff "$scratch/expected" "$scratch/perft"
+fi
+
+# Journals - the first moves of a type 1 against type 2 game are played by
+# humans with a journal, which is resumed halfway and then saved. The resumed
+# journal must match one written in one go, and the board, the save and the
+# journal must all play on to the same final position.
+for board in "$boards/board4x6" "$boards/specboard7" "$boards/board13x15"; do
+    "$program" --verbosity=moves 1 2 "$board" | head -n 6 |
+            awk '{ print $5, $6 }' > "$scratch/moves"
+    rm -f "$scratch/journal"
+    head -n 3 "$scratch/moves" | "$program" --journal="$scratch/journal" \
+            H H "$board" > /dev/null 2>&1
+    { tail -n 3 "$scratch/moves"; echo "s$scratch/save"; } |
+            "$program" --journal="$scratch/journal" H H "$scratch/journal" \
+            > /dev/null 2>&1
+    "$program" --journal="$scratch/whole" H H "$board" < "$scratch/moves" \
+            > /dev/null 2>&1
+    if ! cmp -s "$scratch/journal" "$scratch/whole"; then
+        fail "resumed journal of $board differs"
+    fi
+    for file in "$board" "$scratch/save" "$scratch/journal"; do
+        "$program" --batch 1 2 "$file" | awk '{ print $2, $3, $4, $6 }'
+    done > "$scratch/keys"
+    if [ "$(uniq "$scratch/keys" | wc -l)" -ne 1 ]; then
+        fail "journal of $board:"
+        cat "$scratch/keys"
+    fi
+done
+
+# Saves - each board is saved as text and as binary, the binary save is
+# saved as text again, and is also rewritten with a version 1 header (with
+# the version set to 1 and no key). Both text saves must match, and every
+# save must play on to the same final position as the board.
+for board in "$boards"/board4* "$boards"/specboard* "$boards"/dotboard \
+        "$scratch"/random/1 "$scratch"/random/2 "$scratch"/random/3; do
+    printf 's%s\ns%s\n' "$scratch/text" "$scratch/binary.p2b" |
+            "$program" H H "$board" > /dev/null 2>&1
+    echo "s$scratch/again" | "$program" H H "$scratch/binary.p2b" \
+            > /dev/null 2>&1
+    { head -c 4 "$scratch/binary.p2b"; printf '\001'
+            tail -c +6 "$scratch/binary.p2b" | head -c 11
+            tail -c +25 "$scratch/binary.p2b"; } > "$scratch/version1"
+    if ! cmp -s "$scratch/text" "$scratch/again"; then
+        fail "binary save of $board saves as different text"
+    fi
+    for file in "$board" "$scratch/text" "$scratch/binary.p2b" \
+            "$scratch/version1"; do
+        "$program" --batch 1 2 "$file" | awk '{ print $2, $3, $4, $6 }'
+    done > "$scratch/keys"
+    if [ "$(uniq "$scratch/keys" | wc -l)" -ne 1 ]; then
+        fail "saves of $board:"
+        cat "$scratch/keys"
+    fi
+done
+
+# Kernels - every kernel the machine supports must load boards of every width
+# from 3 to 70 columns (so that rows end partway through a vector or a word,
+# leaving tail bytes) the same way as the scalar kernels, including boards
+# with a bad stone or score in the last cell the kernels check (the one before
+# the last cell of a row, which text_row_valid checks itself). Boards that load
+# the same way must then play out the same way. The boards that load are also
+# benchmarked for a pass (see --bench), which checks the sums of every kernel
+# against the scalar kernels.
+mkdir "$scratch/widths"
+for columns in $(seq 3 70); do
+    random_board "$columns" "$columns" > "$scratch/widths/$columns"
+    sed '4s/.\(..\)$/Z\1/' "$scratch/widths/$columns" \
+            > "$scratch/widths/$columns-stone"
+    sed '5s/.\(...\)$/a\1/' "$scratch/widths/$columns" \
+            > "$scratch/widths/$columns-score"
+done
+for kernels in scalar sse2 avx2; do
+    if ! "$program" --kernels="$kernels" --batch 0 0 "$boards/board4x6" \
+            > /dev/null 2>&1; then
+        continue
+    fi
+    for board in "$scratch"/widths/* "$@" "$boards"/*fail* \
+            "$boards"/notboard* "$boards"/nb3*; do
+        # Human players with no input print the board as loaded, and stop
+        "$program" --kernels="$kernels" H H "$board" < /dev/null 2>&1
+        echo "$board: $?"
+    done > "$scratch/$kernels.loaded"
+    if [ -z "$reference" ]; then
+        reference=$kernels
+    elif ! cmp -s "$scratch/$reference.loaded" "$scratch/$kernels.loaded"
+    then
+        fail "$kernels kernels load boards differently to $reference kernels:"
+        diff "$scratch/$reference.loaded" "$scratch/$kernels.loaded"
+        continue
+    fi
+    "$program" --kernels="$kernels" --batch 0 1 "$scratch"/widths/* "$@" \
+            > "$scratch/$kernels.played" 2> /dev/null
+    if ! cmp -s "$scratch/$reference.played" "$scratch/$kernels.played"; then
+        fail "$kernels kernels play boards differently to $reference kernels:"
+        diff "$scratch/$reference.played" "$scratch/$kernels.played"
+    fi
+done
+for board in "$scratch"/widths/? "$scratch"/widths/?? "$@"; do
+    if "$program" --bench=1 0 0 "$board" 2>&1 | grep -q "results differ"; then
+        fail "kernels differ from scalar kernels on $board:"
+        "$program" --bench=1 0 0 "$board" 2>&1 | grep "results differ"
+    fi
+done
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures checks failed"
+    exit 1
+fi
+echo "All checks passed"